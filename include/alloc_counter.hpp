@@ -0,0 +1,11 @@
+#ifndef __ALLOC_COUNTER_HPP__
+#define __ALLOC_COUNTER_HPP__
+
+#include <cstddef>
+
+// Only available when built with -DTRICOT_COUNT_ALLOCATIONS=ON: the global
+// operator new is then replaced by a counting one. Every cv::Mat allocation
+// goes through it too, for its reference counted header.
+size_t allocationCount();
+
+#endif // __ALLOC_COUNTER_HPP__
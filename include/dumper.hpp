@@ -0,0 +1,76 @@
+#ifndef __DUMPER_HPP__
+#define __DUMPER_HPP__
+
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+#define DUMP_QUEUE_CAPACITY 16
+
+// Builds the image to write, called on the writer thread
+typedef std::function<cv::Mat()> DumpRenderer;
+
+// How debug images are encoded on disk
+enum class DumpFormat {
+  PngFast,         // PNG, compression level 1
+  PngUncompressed, // PNG, compression level 0
+  Raw              // binary PNM (.ppm / .pgm), no compression at all
+};
+
+// Writes debug images from a background thread so that the capture loop never
+// waits on the filesystem or the PNG encoder. When the queue is full, new
+// images are dropped instead of blocking the caller.
+class ImageDumper {
+public:
+  explicit ImageDumper(size_t capacity = DUMP_QUEUE_CAPACITY,
+                       DumpFormat format = DumpFormat::PngFast);
+  ~ImageDumper();
+  ImageDumper(const ImageDumper &) = delete;
+  ImageDumper &operator=(const ImageDumper &) = delete;
+
+  bool push(const std::string &name, const cv::Mat &img,
+            const std::string &path);
+  bool push(const std::string &name, DumpRenderer render,
+            const std::string &path);
+  void setFormat(DumpFormat format);
+  size_t dropped() const;
+
+  // "png", "png0" or "raw"
+  static bool parseFormat(const char *name, DumpFormat &format);
+
+private:
+  struct Job {
+    std::string name;
+    std::string path;
+    std::time_t time;
+    cv::Mat image;
+    DumpRenderer render;
+  };
+
+  size_t capacity;
+  DumpFormat format;
+  std::deque<Job> queue;
+  mutable std::mutex mutex;
+  std::condition_variable cond;
+  bool stopping = false;
+  size_t droppedCount = 0;
+  std::thread worker;
+
+  // Only touched by the worker thread
+  std::unordered_set<std::string> createdDirs;
+  std::time_t lastTime = 0;
+  std::string lastTimestamp;
+
+  bool enqueue(Job job);
+  void run();
+  void write(const Job &job, DumpFormat fmt);
+  const std::string &timestamp(std::time_t time);
+};
+
+#endif // __DUMPER_HPP__
@@ -0,0 +1,215 @@
+#ifndef __KMEANS_HPP__
+#define __KMEANS_HPP__
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#define KMEANS_MAX_ITERATIONS 20
+
+// K-means over the pixels of a small CV_8UC3 patch, for dominant colors.
+// - integer arithmetic on BGR planes: the distance loops are branch free so
+//   that the compiler vectorizes them
+// - deterministic: the first centers are picked farthest point first
+// - warm start: the centers of the previous run are reused, consecutive
+//   frames of the same stripe converge in one or two iterations
+template <int K> class ColorKMeans {
+public:
+  static_assert(K > 0, "at least one cluster");
+
+  // Clusters the patch and returns the index of the largest cluster
+  int run(const cv::Mat &image) {
+    CV_Assert(image.type() == CV_8UC3 && !image.empty());
+
+    const int n = static_cast<int>(image.total());
+    load(image, n);
+    if (!isWarm) {
+      seed(n);
+    }
+
+    std::fill(labels.begin(), labels.begin() + n, -1);
+    lastIterations = 0;
+    bool changed = true;
+    while (changed && lastIterations < KMEANS_MAX_ITERATIONS) {
+      changed = assign(n);
+      update(n);
+      ++lastIterations;
+    }
+
+    isWarm = true;
+    return largest();
+  }
+
+  // Forgets the centers of the previous run
+  void reset() { isWarm = false; }
+
+  // Largest cluster, lowest index on ties, optionally skipping one
+  int largest(int skip = -1) const {
+    int best = skip == 0 && K > 1 ? 1 : 0;
+    for (int c = 0; c < K; ++c) {
+      if (c != skip && sizes[c] > sizes[best]) {
+        best = c;
+      }
+    }
+    return best;
+  }
+
+  cv::Vec3b center(int cluster) const {
+    return cv::Vec3b(static_cast<uchar>(centers[cluster][0]),
+                     static_cast<uchar>(centers[cluster][1]),
+                     static_cast<uchar>(centers[cluster][2]));
+  }
+  int size(int cluster) const { return sizes[cluster]; }
+  int iterations() const { return lastIterations; }
+
+private:
+  std::array<std::array<int32_t, 3>, K> centers{};
+  std::array<int32_t, K> sizes{};
+  bool isWarm = false;
+  int lastIterations = 0;
+
+  // Grown once, reused afterwards
+  std::vector<int32_t> planes[3];
+  std::vector<int32_t> distances;
+  std::vector<int32_t> labels;
+  std::vector<int32_t> nextLabels;
+
+  static int32_t distance(int32_t b, int32_t g, int32_t r,
+                          const std::array<int32_t, 3> &center) {
+    int32_t dB = b - center[0];
+    int32_t dG = g - center[1];
+    int32_t dR = r - center[2];
+    return dB * dB + dG * dG + dR * dR;
+  }
+
+  void load(const cv::Mat &image, int n) {
+    if (distances.size() < static_cast<size_t>(n)) {
+      for (auto &plane : planes) {
+        plane.resize(n);
+      }
+      distances.resize(n);
+      labels.resize(n);
+      nextLabels.resize(n);
+    }
+
+    int32_t *b = planes[0].data();
+    int32_t *g = planes[1].data();
+    int32_t *r = planes[2].data();
+    for (int y = 0, i = 0; y < image.rows; ++y) {
+      const uchar *row = image.ptr<uchar>(y);
+      for (int x = 0; x < image.cols; ++x, ++i) {
+        b[i] = row[3 * x];
+        g[i] = row[3 * x + 1];
+        r[i] = row[3 * x + 2];
+      }
+    }
+  }
+
+  // The pixel closest to the mean, then repeatedly the pixel farthest from
+  // every center picked so far.
+  void seed(int n) {
+    const int32_t *b = planes[0].data();
+    const int32_t *g = planes[1].data();
+    const int32_t *r = planes[2].data();
+
+    std::array<int64_t, 3> sum{};
+    for (int i = 0; i < n; ++i) {
+      sum[0] += b[i];
+      sum[1] += g[i];
+      sum[2] += r[i];
+    }
+    std::array<int32_t, 3> mean;
+    for (int ch = 0; ch < 3; ++ch) {
+      mean[ch] = static_cast<int32_t>((sum[ch] + n / 2) / n);
+    }
+
+    int first = 0;
+    for (int i = 0, closest = std::numeric_limits<int32_t>::max(); i < n;
+         ++i) {
+      int32_t d = distance(b[i], g[i], r[i], mean);
+      if (d < closest) {
+        closest = d;
+        first = i;
+      }
+    }
+    centers[0] = {b[first], g[first], r[first]};
+
+    int32_t *nearest = distances.data();
+    for (int i = 0; i < n; ++i) {
+      nearest[i] = distance(b[i], g[i], r[i], centers[0]);
+    }
+    for (int c = 1; c < K; ++c) {
+      int farthest = static_cast<int>(
+          std::max_element(nearest, nearest + n) - nearest);
+      centers[c] = {b[farthest], g[farthest], r[farthest]};
+      for (int i = 0; i < n; ++i) {
+        nearest[i] = std::min(nearest[i], distance(b[i], g[i], r[i],
+                                                   centers[c]));
+      }
+    }
+  }
+
+  // Returns true when a pixel changed cluster
+  bool assign(int n) {
+    const int32_t *b = planes[0].data();
+    const int32_t *g = planes[1].data();
+    const int32_t *r = planes[2].data();
+    int32_t *best = distances.data();
+    int32_t *next = nextLabels.data();
+
+    std::fill(best, best + n, std::numeric_limits<int32_t>::max());
+    for (int c = 0; c < K; ++c) {
+      const int32_t cB = centers[c][0];
+      const int32_t cG = centers[c][1];
+      const int32_t cR = centers[c][2];
+      for (int i = 0; i < n; ++i) {
+        int32_t dB = b[i] - cB;
+        int32_t dG = g[i] - cG;
+        int32_t dR = r[i] - cR;
+        int32_t d = dB * dB + dG * dG + dR * dR;
+        bool closer = d < best[i];
+        best[i] = closer ? d : best[i];
+        next[i] = closer ? c : next[i];
+      }
+    }
+
+    int32_t changes = 0;
+    const int32_t *current = labels.data();
+    for (int i = 0; i < n; ++i) {
+      changes += current[i] != next[i];
+    }
+    labels.swap(nextLabels);
+    return changes != 0;
+  }
+
+  // Rounded mean of every cluster, empty clusters keep their center
+  void update(int n) {
+    const int32_t *b = planes[0].data();
+    const int32_t *g = planes[1].data();
+    const int32_t *r = planes[2].data();
+    const int32_t *label = labels.data();
+
+    std::array<std::array<int64_t, 3>, K> sums{};
+    sizes.fill(0);
+    for (int i = 0; i < n; ++i) {
+      sums[label[i]][0] += b[i];
+      sums[label[i]][1] += g[i];
+      sums[label[i]][2] += r[i];
+      ++sizes[label[i]];
+    }
+    for (int c = 0; c < K; ++c) {
+      if (sizes[c] == 0) {
+        continue;
+      }
+      for (int ch = 0; ch < 3; ++ch) {
+        centers[c][ch] =
+            static_cast<int32_t>((sums[c][ch] + sizes[c] / 2) / sizes[c]);
+      }
+    }
+  }
+};
+
+#endif // __KMEANS_HPP__
@@ -0,0 +1,108 @@
+#ifndef __LOGGER_HPP__
+#define __LOGGER_HPP__
+
+#include <array>
+#include <atomic>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+// Must be a power of two
+#define LOG_QUEUE_CAPACITY 1024
+#define LOG_MESSAGE_SIZE 232
+#define LOG_DRAIN_INTERVAL_MS 10
+
+// Messages below this level are compiled out, see TRICOT_LOG_LEVEL
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+enum class LogLevel { Debug, Info, Warning, Error, Off };
+
+// Asynchronous sink: the capture threads format their messages into a
+// bounded lock-free ring (Vyukov MPMC queue, used as MPSC) and a background
+// thread writes them out. Logging never blocks nor allocates, messages are
+// dropped and counted when the ring is full.
+//
+// Decisions can also be traced, one JSON object per line, to their own file.
+class Logger {
+public:
+  static Logger &instance();
+
+  ~Logger();
+  Logger(const Logger &) = delete;
+  Logger &operator=(const Logger &) = delete;
+
+  bool start(LogLevel level, const std::string &tracePath = "");
+  void stop();
+
+  void setLevel(LogLevel level) {
+    minLevel.store(level, std::memory_order_relaxed);
+  }
+  bool enabled(LogLevel level) const {
+    return level >= minLevel.load(std::memory_order_relaxed);
+  }
+  bool tracing() const { return isTracing.load(std::memory_order_relaxed); }
+  uint64_t dropped() const {
+    return droppedCount.load(std::memory_order_relaxed);
+  }
+
+  void log(LogLevel level, const char *format, ...)
+      __attribute__((format(printf, 3, 4)));
+  void trace(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+  // "debug", "info", "warning", "error" or "off"
+  static bool parseLevel(const char *name, LogLevel &level);
+
+private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    bool isTrace;
+    LogLevel level;
+    char text[LOG_MESSAGE_SIZE];
+  };
+
+  Logger();
+
+  std::array<Slot, LOG_QUEUE_CAPACITY> slots;
+  alignas(64) std::atomic<size_t> enqueuePos{0};
+  alignas(64) size_t dequeuePos = 0; // only touched by the drain thread
+  std::atomic<uint64_t> droppedCount{0};
+
+  std::atomic<LogLevel> minLevel{LogLevel::Info};
+  std::atomic<bool> isTracing{false};
+  std::atomic<bool> stopping{false};
+  std::FILE *traceFile = nullptr;
+  std::thread worker;
+
+  Slot *claim(size_t &pos);
+  void publish(Slot *slot, size_t pos);
+  void push(bool isTrace, LogLevel level, const char *format, va_list args);
+  void run();
+  bool drain();
+};
+
+#define LOG(level, ...)                                                        \
+  do {                                                                         \
+    if (static_cast<int>(level) >= LOG_COMPILE_LEVEL &&                        \
+        Logger::instance().enabled(level)) {                                   \
+      Logger::instance().log(level, __VA_ARGS__);                              \
+    }                                                                          \
+  } while (0)
+
+#define LOG_DEBUG(...) LOG(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARNING(...) LOG(LogLevel::Warning, __VA_ARGS__)
+#define LOG_ERROR(...) LOG(LogLevel::Error, __VA_ARGS__)
+
+#define TRACE(...)                                                             \
+  do {                                                                         \
+    if (Logger::instance().tracing()) {                                        \
+      Logger::instance().trace(__VA_ARGS__);                                   \
+    }                                                                          \
+  } while (0)
+
+#endif // __LOGGER_HPP__
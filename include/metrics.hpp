@@ -0,0 +1,97 @@
+#ifndef __METRICS_HPP__
+#define __METRICS_HPP__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#define METRICS_INTERVAL_MS 5000
+
+// Monotonic counters, exported with a `_total` suffix
+enum class Counter {
+  FramesRead,
+  HeaderDetectionsTried,
+  HeaderDetectionsSucceeded,
+  BodyClassifications,
+  InstructionsEmitted,
+  Count
+};
+
+// Last observed values
+enum class Gauge {
+  ColorDistanceBest,   // distance to the closest palette color
+  ColorDistanceMargin, // distance gap between the two closest palette colors
+  SeparatorDistance,   // distance to the separator color
+  FrameRate,           // frames read per second, over the last interval
+  DecodeRate,          // instructions emitted per second, over the last interval
+  Count
+};
+
+enum class MetricsFormat {
+  Prometheus, // text exposition format, rewritten atomically (node exporter)
+  JsonLines   // one JSON object appended per interval
+};
+
+// Lock-free counters and gauges, updated from the capture loop and
+// periodically written to a file by a background thread.
+class Metrics {
+public:
+  Metrics() = default;
+  ~Metrics();
+  Metrics(const Metrics &) = delete;
+  Metrics &operator=(const Metrics &) = delete;
+
+  void increment(Counter counter, uint64_t n = 1) {
+    counters[static_cast<size_t>(counter)].fetch_add(
+        n, std::memory_order_relaxed);
+  }
+  void set(Gauge gauge, double value) {
+    gauges[static_cast<size_t>(gauge)].store(value, std::memory_order_relaxed);
+  }
+  uint64_t get(Counter counter) const {
+    return counters[static_cast<size_t>(counter)].load(
+        std::memory_order_relaxed);
+  }
+  double get(Gauge gauge) const {
+    return gauges[static_cast<size_t>(gauge)].load(std::memory_order_relaxed);
+  }
+
+  bool start(const std::string &path, const std::string &label = "",
+             std::chrono::milliseconds interval =
+                 std::chrono::milliseconds(METRICS_INTERVAL_MS));
+  void stop();
+
+private:
+  static constexpr size_t COUNTERS = static_cast<size_t>(Counter::Count);
+  static constexpr size_t GAUGES = static_cast<size_t>(Gauge::Count);
+
+  std::array<std::atomic<uint64_t>, COUNTERS> counters{};
+  std::array<std::atomic<double>, GAUGES> gauges{};
+
+  std::string path;
+  std::string label;
+  MetricsFormat format = MetricsFormat::JsonLines;
+  std::chrono::milliseconds interval{METRICS_INTERVAL_MS};
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable cond;
+  bool stopping = false;
+
+  // Only touched by the worker thread
+  std::chrono::steady_clock::time_point lastTime;
+  uint64_t lastFrames = 0;
+  uint64_t lastInstructions = 0;
+
+  void run();
+  void updateRates();
+  bool write() const;
+  bool writePrometheus() const;
+  bool writeJsonLine() const;
+};
+
+#endif // __METRICS_HPP__
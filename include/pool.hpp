@@ -0,0 +1,49 @@
+#ifndef __POOL_HPP__
+#define __POOL_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::function<void()> Task;
+
+// Work-stealing thread pool: every worker owns a deque, pops its own tasks
+// from the back and steals from the front of the others when it runs dry.
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void submit(Task task);
+  // Runs fn(0) .. fn(n - 1) and returns once they are all done. The caller
+  // takes part in the work, so it is safe to call from inside a task.
+  void parallelFor(size_t n, const std::function<void(size_t)> &fn);
+  size_t size() const;
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  std::atomic<size_t> nextQueue{0};
+  std::atomic<size_t> pending{0};
+  std::mutex sleepMutex;
+  std::condition_variable sleepCond;
+  bool stopping = false;
+
+  void run(size_t self);
+  bool tryRun(size_t self);
+  bool pop(size_t i, Task &task, bool back);
+};
+
+#endif // __POOL_HPP__
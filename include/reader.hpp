@@ -1,11 +1,28 @@
 #ifndef __READER_HPP__
 #define __READER_HPP__
 
+#include "dumper.hpp"
+#include "kmeans.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "pool.hpp"
+#include "recorder.hpp"
 #include "verbose.hpp"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <vector>
@@ -17,16 +34,124 @@
 #define BODY_ROI_WIDTH 48
 #define BODY_ROI_HEIGHT 12
 #define TEMPLATE_THRESHOLD 0.8
+#define COLOR_THRESHOLD 500
+#define HEADER_SECTIONS 8
+#define DOMINANT_COLOR_CLUSTERS 4
+// Instructions decoded before the command buffer has to grow
+#define COMMAND_CAPACITY 4096
+// Minimum number of result rows per tile in the parallel template search
+#define TEMPLATE_TILE_ROWS 64
+// Largest score gap allowed between the tiled and the full template search,
+// which must also agree on the location
+#define TEMPLATE_SCORE_TOLERANCE 1e-5
+#define HEADER_CACHE_FILE "assets/calibration/header.dat"
+#define HEADER_CACHE_MAGIC 0x31524448 // "HDR1"
+// Differing bits allowed between two header fingerprints
+#define HEADER_HASH_MAX_DISTANCE 8
+// Search margin around the cached end border, in pixels
+#define HEADER_VERIFY_MARGIN 8
+// Frames the cached header is checked against before giving up on it
+#define HEADER_CACHE_ATTEMPTS 50
 
 typedef std::map<std::string, cv::Mat> Template;
 typedef std::unordered_map<std::string, cv::Vec3b> Color;
 
+typedef ColorKMeans<DOMINANT_COLOR_CLUSTERS> KMeans;
+
+// Palette and geometry of the last decoded header, written next to the
+// calibration values. Positions are relative to the roi.
+struct HeaderCache {
+  uint32_t magic = 0;
+  uint64_t fingerprint = 0; // average hash of the header region
+  int32_t header[4] = {};   // x, y, width, height
+  int32_t bodyRoiPos[2] = {};
+  char keys[HEADER_SECTIONS] = {};
+  uint8_t colors[HEADER_SECTIONS][3] = {};
+  uint8_t separator[3] = {};
+};
+
+struct Detection {
+  double score = 0.0;
+  cv::Point match; // best match, in roi coordinates
+  bool found = false;
+  cv::Point location; // in frame coordinates, when found
+};
+
+// One horizontal tile of a template search
+struct MatchJob {
+  const cv::Mat *templ;
+  cv::Mat *result;
+  Detection *detection;
+  int tile;
+  int begin; // first result row
+  int end;   // past the last result row
+};
+
+struct TileMatch {
+  double score;
+  cv::Point match;
+};
+
+// Pixel format requested from the camera
+// What show() draws: the annotated frame and, once the body is decoded, the
+// separator color and the magnified body
+struct DisplayFrames {
+  cv::Mat frame;
+  cv::Mat separator;
+  cv::Mat magnified;
+  bool isBodyDisplayed = false;
+};
+
+enum class CaptureMode {
+  BGR, // frames converted by the backend
+  YUYV // native 4:2:2 frames, converted by us only where color is needed
+};
+
 class VideoProcessor {
 public:
   VideoProcessor();
   ~VideoProcessor() = default;
   void processVideoStream();
-  VerboseOption verbose;
+
+  // Stepwise interface, used to run several streams in one process
+  bool open();
+  bool step();
+  bool handleKey(int key);
+  void show();
+  // Multi-stream hand-off: publish() copies the images to display after a
+  // step, on the stepping thread, and showPublished() shows the last ones
+  // published, on the main thread
+  void publish();
+  void showPublished();
+  void close();
+  // Replaces the camera, e.g. with generated frames
+  void setFrameSource(std::unique_ptr<FrameSource> source);
+  const std::string &getCommand() const;
+  bool isDecodingBody() const;
+  size_t getMatchingMismatches() const;
+
+  VerboseOption verbose = RUN_VERBOSE;
+  // Camera index, or video file / URL
+  std::string source = "0";
+  // Tells streams apart in window titles, dumps and metrics
+  std::string streamName;
+  int colorThreshold = COLOR_THRESHOLD;
+  bool saveImages = true;
+  DumpFormat dumpFormat = DumpFormat::PngFast;
+  // Text banners are only useful when the frame is displayed
+  bool drawOverlays = true;
+  // Shared worker threads, for the header search and analysis
+  ThreadPool *pool = nullptr;
+  // Tiled template search on the pool, same result as a full match
+  bool parallelMatching = true;
+  // Checks every tiled search against a full single-threaded match
+  bool verifyMatching = false;
+  CaptureMode captureMode = CaptureMode::BGR;
+  std::string metricsPath;
+  std::string recordPath;
+  std::string replayPath;
+  // Palette of the last header, for fast restarts. Empty to disable.
+  std::string headerCachePath = HEADER_CACHE_FILE;
 
 private:
   bool read = true;
@@ -36,6 +161,8 @@ private:
   Template headerBorderTemplates;
   Template endTemplate;
   Color colors;
+  ImageDumper dumper;
+  Metrics metrics;
 
   cv::Point bodyRoiPos;
   cv::Vec3b separatorColorBGR;
@@ -43,24 +170,82 @@ private:
   std::string command;
   bool lookForColor;
 
+  cv::Mat frame;
+  cv::Mat rawFrame;
+  // Frame as delivered by frameSource, possibly a read-only file mapping
+  cv::Mat sourceFrame;
+  cv::Mat roiLuma;
+
+  // Per-frame scratch space, so that the steady state does not allocate
+  cv::Mat grayRoi;
+  Template matchResults;
+  std::map<std::string, Detection> detections;
+  std::vector<MatchJob> matchJobs;
+  std::vector<TileMatch> tileMatches;
+  // Keep their centers between calls, as a warm start for the next patch
+  KMeans bodyKMeans;
+  // One per header section, plus one for the separator
+  std::array<KMeans, HEADER_SECTIONS + 1> headerKMeans;
+  std::string overlayText;
+  // Rendered banners, keyed by the address of their file-scope message
+  std::map<const std::string *, cv::Mat> banners;
+  FrameRecorder recorder;
+  std::unique_ptr<FrameSource> frameSource;
+
+  std::string videoWindow;
+  std::string separatorWindow;
+  std::string magnifiedWindow;
+  cv::Mat separatorDisplay;
+  cv::Mat magnifiedBody;
+  bool isBodyDisplayed = false;
+  // Filled by publish() then swapped with displayReady, which the main
+  // thread swaps with displayFront: only displayReady is shared
+  DisplayFrames displayBack;
+  DisplayFrames displayReady;
+  DisplayFrames displayFront;
+  bool isDisplayReady = false;
+  std::mutex displayMutex;
+  void show(const DisplayFrames &display);
+  HeaderCache headerCache;
+  int headerCacheAttempts = 0;
+  size_t matchingMismatches = 0;
+  std::string windowName(const std::string &base) const;
+
   bool openVideoStream();
+  bool openRecorder();
+  bool readFrame(cv::Mat &frame);
   void processHeader(cv::Mat &frame, cv::Mat &headerRoi, int x, int y);
   void processBody(cv::Mat &frame);
+  cv::Rect getBodyRoiRect() const;
 
   bool loadTemplates(const std::string &path, Template &templ);
   void detectTemplate(cv::Mat &frame, Template &templs);
+  void matchTemplatesTiled(const cv::Mat &gray, Template &templs);
+  void verifyTiledMatches(const cv::Mat &gray, const Template &templs);
+  cv::Mat roiToGray(const cv::Mat &frame);
+
+  bool isHeaderCacheEnabled() const;
+  static uint64_t averageHash(const cv::Mat &gray);
+  bool restoreHeaderCache(const cv::Mat &frame);
+  bool verifyHeaderCache(const cv::Mat &gray, const cv::Mat &templ,
+                         cv::Point &endLoc);
+  void saveHeaderCache(const cv::Mat &gray, const cv::Rect &header);
 
   bool areColorsSimilar(const cv::Vec3b &color1, const cv::Vec3b &color2);
   std::string findClosestColorKey(const cv::Vec3b &dominant);
   int colorDistanceBGR(const cv::Vec3b &color1, const cv::Vec3b &color2);
   cv::Vec3b getDominantColorBGR(const cv::Mat &image);
-  cv::Vec3b getDominantColorBGR_KMeans(const cv::Mat &image, int k = 4);
+  cv::Vec3b getDominantColorBGR_KMeans(const cv::Mat &image);
+  cv::Vec3b getDominantColorBGR_KMeans(const cv::Mat &image, KMeans &kmeans);
 
   void printVerbose(cv::Mat &frame, const std::string &text);
   void verboseMagnifyImage(const cv::Mat &img, int n = 4);
   void saveImage(const std::string &name, cv::Mat &img,
                  const std::string &path);
-  void saveSeparatorColor(cv::Mat &roi, int width, int height);
+  void saveImage(const std::string &name, DumpRenderer render,
+                 const std::string &path);
+  void saveSeparatorColor(int width, int height);
+  void parallelFor(size_t n, const std::function<void(size_t)> &fn);
 
       enum class AdjustmentMode {
         Brightness,
@@ -92,7 +277,12 @@ private:
   }
   void saveCurrentAdjustments() const;
   void loadAdjustments();
-  void adjustFrame(cv::Mat &frame) const;
+  cv::Mat adjustmentLut;
+  double lutBrightness = 0.0;
+  double lutContrast = 0.0;
+  bool isAdjustmentIdentity = true;
+  void updateAdjustmentLut();
+  void adjustFrame(const cv::Mat &source, cv::Mat &frame);
   bool handleCalibrationControl(const int &key, cv::Mat &frame);
   void printVerboseCalibration(cv::Mat &frame);
 };
@@ -0,0 +1,98 @@
+#ifndef __RECORDER_HPP__
+#define __RECORDER_HPP__
+
+#include "source.hpp"
+#include <cstdint>
+#include <fstream>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#define RECORDING_MAGIC "TRICREC1"
+#define RECORDING_VERSION 2
+// Frames start on a cache line so that replayed Mats are well aligned
+#define RECORDING_ALIGNMENT 64
+
+/**
+ * File layout:
+ *   RecordingHeader, padded to RECORDING_ALIGNMENT
+ *   frame 0, frame 1, ... each padded to RECORDING_ALIGNMENT
+ *   RecordingIndexEntry[frameCount]
+ * The header is rewritten on close with the frame count and index offset. A
+ * recording that was never closed can still be replayed, without timestamps.
+ * Frames are stored before calibration: since version 2 the header keeps the
+ * brightness and contrast they were captured with, for an exact replay.
+ */
+struct RecordingHeader {
+  char magic[8];
+  uint32_t version;
+  int32_t width;
+  int32_t height;
+  int32_t type;
+  uint64_t frameBytes;
+  uint64_t frameCount;
+  uint64_t indexOffset;
+  // Since version 2, version 1 headers end above and leave these at zero
+  double brightness;
+  double contrast;
+};
+
+struct RecordingIndexEntry {
+  uint64_t offset;
+  int64_t timestampNs;
+};
+
+// Appends raw frames and their capture time to a recording
+class FrameRecorder {
+public:
+  FrameRecorder() = default;
+  ~FrameRecorder();
+  FrameRecorder(const FrameRecorder &) = delete;
+  FrameRecorder &operator=(const FrameRecorder &) = delete;
+
+  bool open(const std::string &path, cv::Size size, int type,
+            double brightness = 1.0, double contrast = 1.0);
+  bool append(const cv::Mat &frame, int64_t timestampNs);
+  void close();
+  bool isOpen() const;
+
+private:
+  std::ofstream file;
+  RecordingHeader header{};
+  std::vector<RecordingIndexEntry> index;
+  uint64_t offset = 0;
+};
+
+// Memory maps a recording and hands out Mats pointing straight into it. The
+// mapping is read-only: replayed frames must be copied before drawing on them.
+class FrameReplay : public FrameSource {
+public:
+  FrameReplay() = default;
+  ~FrameReplay() override;
+  FrameReplay(const FrameReplay &) = delete;
+  FrameReplay &operator=(const FrameReplay &) = delete;
+
+  bool open(const std::string &path);
+  void close();
+
+  bool read(cv::Mat &frame) override;
+  cv::Rect roi() const override;
+
+  size_t frameCount() const;
+  // False for version 1 recordings, which did not keep them
+  bool calibration(double &brightness, double &contrast) const;
+  cv::Mat frameAt(size_t i) const;
+  int64_t timestampAt(size_t i) const;
+
+private:
+  uint8_t *data = nullptr;
+  size_t size = 0;
+  RecordingHeader header{};
+  const RecordingIndexEntry *index = nullptr;
+  size_t count = 0;
+  size_t next = 0;
+
+  uint64_t frameOffset(size_t i) const;
+};
+
+#endif // __RECORDER_HPP__
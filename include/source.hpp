@@ -0,0 +1,17 @@
+#ifndef __SOURCE_HPP__
+#define __SOURCE_HPP__
+
+#include <opencv2/opencv.hpp>
+
+// Frames coming from somewhere else than the camera
+class FrameSource {
+public:
+  virtual ~FrameSource() = default;
+
+  // Returns false once the source is exhausted
+  virtual bool read(cv::Mat &frame) = 0;
+  // Region of the frames to search for the header, in frame coordinates
+  virtual cv::Rect roi() const = 0;
+};
+
+#endif // __SOURCE_HPP__
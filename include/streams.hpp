@@ -0,0 +1,21 @@
+#ifndef __STREAMS_HPP__
+#define __STREAMS_HPP__
+
+#include "pool.hpp"
+#include "reader.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef std::vector<std::unique_ptr<VideoProcessor>> Streams;
+
+// Every stream is read and decoded by its own thread, which splits its
+// header search and analysis on the streams' shared pool. The calling thread
+// shows whatever each stream published last, so a slow or hung camera only
+// holds back its own station.
+void processVideoStreams(Streams &streams);
+
+// "out/metrics.prom" + "stream1" -> "out/metrics_stream1.prom"
+std::string streamPath(const std::string &path, const std::string &name);
+
+#endif // __STREAMS_HPP__
@@ -0,0 +1,65 @@
+#ifndef __SYNTHETIC_HPP__
+#define __SYNTHETIC_HPP__
+
+#include "reader.hpp"
+#include "source.hpp"
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#define SYNTHETIC_HEADER_FRAMES 5
+#define SYNTHETIC_STRIPE_FRAMES 4
+#define SYNTHETIC_SECTION_HEIGHT 40
+// Body frames not counted in the steady state allocations
+#define SYNTHETIC_WARMUP_FRAMES 2
+
+struct SyntheticOptions {
+  int headerFrames = SYNTHETIC_HEADER_FRAMES; // frames showing the header
+  int stripeFrames = SYNTHETIC_STRIPE_FRAMES; // frames per body stripe
+  double noise = 0.0;    // standard deviation of the gaussian pixel noise
+  double lighting = 0.0; // amplitude of the brightness drift, in levels
+  double scale = 0.0;    // amplitude of the zoom drift, 0.05 is +/- 5 %
+  uint64_t seed = 42;
+};
+
+// Renders a knitted program the way the camera sees it: the header borders
+// around the 8 instruction colors, then one body stripe per instruction,
+// each followed by a separator stripe. Frames only hold the roi.
+class SyntheticSource : public FrameSource {
+public:
+  SyntheticSource(const std::string &program,
+                  const SyntheticOptions &options = SyntheticOptions());
+
+  bool load();
+  bool read(cv::Mat &frame) override;
+  cv::Rect roi() const override;
+  size_t frameCount() const;
+
+  // Instructions of the header, top to bottom
+  static const std::string instructions;
+
+private:
+  std::string program;
+  SyntheticOptions options;
+  cv::RNG rng;
+  size_t next = 0;
+
+  std::vector<cv::Vec3b> palette;
+  cv::Vec3b separator;
+  cv::Rect bodyRect;
+  cv::Mat headerScene;
+  cv::Mat scene;
+  cv::Mat noise;
+
+  void renderScene(size_t i);
+  void applyEffects(cv::Mat &frame, size_t i);
+};
+
+// Decodes the synthetic program and reports accuracy and frames per second.
+// Returns false when the decoded program differs from the expected one.
+bool runSyntheticBenchmark(VideoProcessor &processor,
+                           const std::string &programPath,
+                           const SyntheticOptions &options);
+
+#endif // __SYNTHETIC_HPP__
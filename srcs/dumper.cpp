@@ -0,0 +1,165 @@
+#include "../include/dumper.hpp"
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+/**
+ * CONSTRUCTOR / DESTRUCTOR
+ */
+
+ImageDumper::ImageDumper(size_t capacity, DumpFormat format)
+    : capacity(capacity), format(format) {
+  worker = std::thread(&ImageDumper::run, this);
+}
+
+ImageDumper::~ImageDumper() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  cond.notify_one();
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+/**
+ * QUEUE
+ */
+
+// Never blocks on I/O: the image is copied and handed to the worker, or
+// dropped when the queue is already full.
+bool ImageDumper::push(const std::string &name, const cv::Mat &img,
+                       const std::string &path) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.size() >= capacity) {
+      ++droppedCount;
+      return false;
+    }
+  }
+
+  // Copy outside the lock, the caller keeps drawing on its frame
+  return enqueue(Job{name, path, std::time(nullptr), img.clone(), nullptr});
+}
+
+// The image is only built on the writer thread, e.g. debug composites that
+// have no business in the capture loop.
+bool ImageDumper::push(const std::string &name, DumpRenderer render,
+                       const std::string &path) {
+  return enqueue(
+      Job{name, path, std::time(nullptr), cv::Mat(), std::move(render)});
+}
+
+bool ImageDumper::enqueue(Job job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.size() >= capacity) {
+      ++droppedCount;
+      return false;
+    }
+    queue.push_back(std::move(job));
+  }
+  cond.notify_one();
+  return true;
+}
+
+void ImageDumper::setFormat(DumpFormat fmt) {
+  std::lock_guard<std::mutex> lock(mutex);
+  format = fmt;
+}
+
+size_t ImageDumper::dropped() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return droppedCount;
+}
+
+bool ImageDumper::parseFormat(const char *name, DumpFormat &fmt) {
+  if (std::strcmp(name, "png") == 0) {
+    fmt = DumpFormat::PngFast;
+  } else if (std::strcmp(name, "png0") == 0) {
+    fmt = DumpFormat::PngUncompressed;
+  } else if (std::strcmp(name, "raw") == 0) {
+    fmt = DumpFormat::Raw;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void ImageDumper::run() {
+  while (true) {
+    Job job;
+    DumpFormat fmt;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [this] { return stopping || !queue.empty(); });
+      // Flush what is left before leaving
+      if (queue.empty()) {
+        return;
+      }
+      job = std::move(queue.front());
+      queue.pop_front();
+      fmt = format;
+    }
+    write(job, fmt);
+  }
+}
+
+/**
+ * WRITE
+ */
+
+const std::string &ImageDumper::timestamp(std::time_t time) {
+  // Directories are per minute, no need to format the same minute twice
+  if (lastTimestamp.empty() || time / 60 != lastTime / 60) {
+    // Every stream has its own dumper thread: no shared static buffer
+    std::tm local;
+    localtime_r(&time, &local);
+    std::stringstream ss;
+    ss << std::put_time(&local, "%Y%m%d_%H%M");
+    lastTimestamp = ss.str();
+    lastTime = time;
+  }
+  return lastTimestamp;
+}
+
+void ImageDumper::write(const Job &job, DumpFormat fmt) {
+  cv::Mat image = job.render ? job.render() : job.image;
+  if (image.empty()) {
+    return;
+  }
+
+  std::string dirname = job.path + timestamp(job.time);
+  if (createdDirs.count(dirname) == 0) {
+    std::error_code ec;
+    std::filesystem::create_directories(dirname, ec);
+    if (ec) {
+      std::cerr << "Error: could not create " << dirname << ": "
+                << ec.message() << std::endl;
+      return;
+    }
+    createdDirs.insert(dirname);
+  }
+
+  std::vector<int> params;
+  std::string extension = ".png";
+  if (fmt == DumpFormat::Raw &&
+      (image.type() == CV_8UC1 || image.type() == CV_8UC3)) {
+    extension = image.channels() == 1 ? ".pgm" : ".ppm";
+    params = {cv::IMWRITE_PXM_BINARY, 1};
+  } else {
+    int level = fmt == DumpFormat::PngUncompressed ? 0 : 1;
+    params = {cv::IMWRITE_PNG_COMPRESSION, level, cv::IMWRITE_PNG_STRATEGY,
+              cv::IMWRITE_PNG_STRATEGY_RLE};
+  }
+
+  try {
+    cv::imwrite(dirname + "/" + job.name + extension, image, params);
+  } catch (const cv::Exception &e) {
+    std::cerr << "Error: could not write " << job.name << ": " << e.what()
+              << std::endl;
+  }
+}
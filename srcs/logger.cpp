@@ -0,0 +1,192 @@
+#include "../include/logger.hpp"
+#include <chrono>
+#include <cstdarg>
+#include <cstring>
+#include <iostream>
+
+static_assert((LOG_QUEUE_CAPACITY & (LOG_QUEUE_CAPACITY - 1)) == 0,
+              "LOG_QUEUE_CAPACITY must be a power of two");
+
+namespace {
+
+const char *levelNames[] = {"debug", "info", "warning", "error", "off"};
+
+} // namespace
+
+/**
+ * CONSTRUCTOR / DESTRUCTOR
+ */
+
+Logger &Logger::instance() {
+  static Logger logger;
+  return logger;
+}
+
+Logger::Logger() {
+  for (size_t i = 0; i < slots.size(); ++i) {
+    slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+Logger::~Logger() { stop(); }
+
+/**
+ * CONTROL
+ */
+
+bool Logger::start(LogLevel level, const std::string &tracePath) {
+  setLevel(level);
+  if (worker.joinable()) {
+    return true;
+  }
+
+  if (!tracePath.empty()) {
+    traceFile = std::fopen(tracePath.c_str(), "w");
+    if (!traceFile) {
+      std::cerr << "Error: could not open trace file " << tracePath
+                << std::endl;
+      return false;
+    }
+    isTracing.store(true, std::memory_order_relaxed);
+  }
+
+  stopping.store(false, std::memory_order_relaxed);
+  worker = std::thread(&Logger::run, this);
+  return true;
+}
+
+// Writes out whatever is still queued
+void Logger::stop() {
+  stopping.store(true, std::memory_order_relaxed);
+  if (worker.joinable()) {
+    worker.join();
+  }
+  drain();
+  std::fflush(stdout);
+
+  isTracing.store(false, std::memory_order_relaxed);
+  if (traceFile) {
+    std::fclose(traceFile);
+    traceFile = nullptr;
+  }
+
+  uint64_t lost = droppedCount.exchange(0, std::memory_order_relaxed);
+  if (lost) {
+    std::cerr << "Warning: " << lost << " log messages dropped" << std::endl;
+  }
+}
+
+bool Logger::parseLevel(const char *name, LogLevel &level) {
+  for (size_t i = 0; i < sizeof(levelNames) / sizeof(*levelNames); ++i) {
+    if (std::strcmp(name, levelNames[i]) == 0) {
+      level = static_cast<LogLevel>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * PRODUCERS
+ */
+
+void Logger::log(LogLevel level, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  push(false, level, format, args);
+  va_end(args);
+}
+
+void Logger::trace(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  push(true, LogLevel::Info, format, args);
+  va_end(args);
+}
+
+// The message is formatted straight into its slot
+void Logger::push(bool isTrace, LogLevel level, const char *format,
+                  va_list args) {
+  size_t pos;
+  Slot *slot = claim(pos);
+  if (!slot) {
+    droppedCount.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  slot->isTrace = isTrace;
+  slot->level = level;
+  std::vsnprintf(slot->text, sizeof(slot->text), format, args);
+  publish(slot, pos);
+}
+
+// A slot is free for position `pos` when its sequence equals `pos`, and
+// readable once it has been published as `pos + 1`.
+Logger::Slot *Logger::claim(size_t &pos) {
+  pos = enqueuePos.load(std::memory_order_relaxed);
+  for (;;) {
+    Slot &slot = slots[pos & (LOG_QUEUE_CAPACITY - 1)];
+    size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    intptr_t diff =
+        static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+        return &slot;
+      }
+    } else if (diff < 0) {
+      return nullptr; // full
+    } else {
+      pos = enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void Logger::publish(Slot *slot, size_t pos) {
+  slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+/**
+ * DRAIN THREAD
+ */
+
+void Logger::run() {
+  while (!stopping.load(std::memory_order_relaxed)) {
+    if (!drain()) {
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(LOG_DRAIN_INTERVAL_MS));
+    }
+  }
+}
+
+// Returns true when something was written
+bool Logger::drain() {
+  bool wrote = false;
+  for (;;) {
+    Slot &slot = slots[dequeuePos & (LOG_QUEUE_CAPACITY - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) {
+      break;
+    }
+
+    if (!slot.isTrace) {
+      std::FILE *out = slot.level >= LogLevel::Warning ? stderr : stdout;
+      std::fputs(slot.text, out);
+      std::fputc('\n', out);
+    } else if (traceFile) {
+      std::fputs(slot.text, traceFile);
+      std::fputc('\n', traceFile);
+    }
+
+    slot.sequence.store(dequeuePos + LOG_QUEUE_CAPACITY,
+                        std::memory_order_release);
+    ++dequeuePos;
+    wrote = true;
+  }
+
+  if (wrote) {
+    std::fflush(stdout);
+    if (traceFile) {
+      std::fflush(traceFile);
+    }
+  }
+  return wrote;
+}
@@ -1,20 +1,131 @@
+#include "../include/logger.hpp"
 #include "../include/reader.hpp"
+#include "../include/streams.hpp"
+#include "../include/synthetic.hpp"
 // #include "verbose.hpp"
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <opencv2/opencv.hpp>
+#include <sstream>
 
 int main(int argc, char **argv) {
-  VerboseOption verbose;
-  if (argc == 2 && std::strncmp(argv[1], "-v\0", 3) == 0) {
+  VerboseOption verbose = RUN_VERBOSE;
+  bool verboseRequested = false;
+  bool yuyv = false;
+  const char *metricsPath = nullptr;
+  const char *recordPath = nullptr;
+  const char *replayPath = nullptr;
+  std::vector<std::string> sources;
+  const char *programPath = nullptr;
+  SyntheticOptions synthetic;
+  LogLevel logLevel = LogLevel::Info;
+  const char *tracePath = nullptr;
+  DumpFormat dumpFormat = DumpFormat::PngFast;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "-v\0", 3) == 0) {
+      verboseRequested = true;
+    } else if (std::strncmp(argv[i], "-y\0", 3) == 0) {
+      yuyv = true;
+    } else if (std::strncmp(argv[i], "-m\0", 3) == 0 && i + 1 < argc) {
+      metricsPath = argv[++i];
+    } else if (std::strncmp(argv[i], "-r\0", 3) == 0 && i + 1 < argc) {
+      recordPath = argv[++i];
+    } else if (std::strncmp(argv[i], "-p\0", 3) == 0 && i + 1 < argc) {
+      replayPath = argv[++i];
+    } else if (std::strncmp(argv[i], "-s\0", 3) == 0 && i + 1 < argc) {
+      std::stringstream list(argv[++i]);
+      std::string source;
+      while (std::getline(list, source, ',')) {
+        sources.push_back(source);
+      }
+    } else if (std::strncmp(argv[i], "-g\0", 3) == 0 && i + 1 < argc) {
+      programPath = argv[++i];
+    } else if (std::strncmp(argv[i], "-n\0", 3) == 0 && i + 1 < argc) {
+      synthetic.noise = std::atof(argv[++i]);
+    } else if (std::strncmp(argv[i], "-l\0", 3) == 0 && i + 1 < argc) {
+      synthetic.lighting = std::atof(argv[++i]);
+    } else if (std::strncmp(argv[i], "-z\0", 3) == 0 && i + 1 < argc) {
+      synthetic.scale = std::atof(argv[++i]);
+    } else if (std::strncmp(argv[i], "-d\0", 3) == 0 && i + 1 < argc) {
+      if (!Logger::parseLevel(argv[++i], logLevel)) {
+        std::cerr << "Error: unknown log level " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (std::strncmp(argv[i], "-t\0", 3) == 0 && i + 1 < argc) {
+      tracePath = argv[++i];
+    } else if (std::strncmp(argv[i], "-f\0", 3) == 0 && i + 1 < argc) {
+      if (!ImageDumper::parseFormat(argv[++i], dumpFormat)) {
+        std::cerr << "Error: unknown image format " << argv[i] << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  // Streams run unattended and decode their own camera
+  if (sources.size() > 1 && (verboseRequested || replayPath || programPath)) {
+    std::cerr << "Error: -v, -p and -g only apply to a single source"
+              << std::endl;
+    return 1;
+  }
+  if (verboseRequested) {
     verbose = promptVerboseMode();
   }
 
+  if (!Logger::instance().start(logLevel, tracePath ? tracePath : "")) {
+    return 1;
+  }
+
+  // Streams share everything but their source, name and output files
+  auto configure = [&](VideoProcessor &processor, const std::string &name) {
+    processor.streamName = name;
+    processor.dumpFormat = dumpFormat;
+    if (yuyv) {
+      processor.captureMode = CaptureMode::YUYV;
+    }
+    if (metricsPath) {
+      processor.metricsPath =
+          name.empty() ? metricsPath : streamPath(metricsPath, name);
+    }
+    if (recordPath) {
+      processor.recordPath =
+          name.empty() ? recordPath : streamPath(recordPath, name);
+    }
+    if (!name.empty()) {
+      processor.headerCachePath = streamPath(HEADER_CACHE_FILE, name);
+    }
+  };
+
   try {
+    if (sources.size() > 1) {
+      ThreadPool pool;
+      Streams streams;
+      for (size_t i = 0; i < sources.size(); ++i) {
+        streams.push_back(std::make_unique<VideoProcessor>());
+        streams.back()->source = sources[i];
+        streams.back()->pool = &pool;
+        configure(*streams.back(), "stream" + std::to_string(i));
+      }
+      processVideoStreams(streams);
+      return 0;
+    }
+
+    ThreadPool pool;
     VideoProcessor processor;
+    processor.pool = &pool;
     if (verbose) {
       processor.verbose = verbose;
     }
+    if (!sources.empty()) {
+      processor.source = sources.front();
+    }
+    configure(processor, "");
+    if (programPath) {
+      return runSyntheticBenchmark(processor, programPath, synthetic) ? 0 : 1;
+    }
+    if (replayPath) {
+      processor.replayPath = replayPath;
+    }
     processor.processVideoStream();
   } catch (const cv::Exception &e) {
     std::cerr << "OpenCV error: " << e.what() << std::endl;
@@ -0,0 +1,178 @@
+#include "../include/metrics.hpp"
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const char *counterNames[] = {
+    "frames_read", "header_detections_tried", "header_detections_succeeded",
+    "body_classifications", "instructions_emitted"};
+
+const char *counterHelp[] = {
+    "Frames read from the video source",
+    "Frames searched for the header borders",
+    "Frames where both header borders were found",
+    "Body regions classified",
+    "Instructions appended to the decoded program"};
+
+const char *gaugeNames[] = {"color_distance_best", "color_distance_margin",
+                            "separator_distance", "frame_rate", "decode_rate"};
+
+const char *gaugeHelp[] = {
+    "Squared BGR distance to the closest palette color",
+    "Squared BGR distance gap between the two closest palette colors",
+    "Squared BGR distance to the separator color",
+    "Frames read per second over the last interval",
+    "Instructions emitted per second over the last interval"};
+
+static_assert(sizeof(counterNames) / sizeof(*counterNames) ==
+                  static_cast<size_t>(Counter::Count),
+              "every counter needs a name");
+static_assert(sizeof(gaugeNames) / sizeof(*gaugeNames) ==
+                  static_cast<size_t>(Gauge::Count),
+              "every gauge needs a name");
+
+bool endsWith(const std::string &str, const std::string &suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+/**
+ * CONSTRUCTOR / DESTRUCTOR
+ */
+
+Metrics::~Metrics() { stop(); }
+
+/**
+ * EXPORT
+ */
+
+// `.prom` files are written in the Prometheus text format, anything else as
+// JSON lines.
+bool Metrics::start(const std::string &filePath, const std::string &name,
+                    std::chrono::milliseconds period) {
+  if (worker.joinable()) {
+    return true;
+  }
+
+  path = filePath;
+  label = name;
+  interval = period;
+  format = endsWith(path, ".prom") ? MetricsFormat::Prometheus
+                                   : MetricsFormat::JsonLines;
+  stopping = false;
+  lastTime = std::chrono::steady_clock::now();
+  lastFrames = get(Counter::FramesRead);
+  lastInstructions = get(Counter::InstructionsEmitted);
+
+  if (!write()) {
+    std::cerr << "Error: could not write metrics to " << path << std::endl;
+    return false;
+  }
+
+  worker = std::thread(&Metrics::run, this);
+  return true;
+}
+
+// Writes a last snapshot so that short sessions are not lost
+void Metrics::stop() {
+  if (!worker.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  cond.notify_one();
+  worker.join();
+
+  updateRates();
+  write();
+}
+
+void Metrics::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!cond.wait_for(lock, interval, [this] { return stopping; })) {
+    lock.unlock();
+    updateRates();
+    write();
+    lock.lock();
+  }
+}
+
+void Metrics::updateRates() {
+  auto now = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(now - lastTime).count();
+  if (seconds <= 0.0) {
+    return;
+  }
+
+  uint64_t frames = get(Counter::FramesRead);
+  uint64_t instructions = get(Counter::InstructionsEmitted);
+  set(Gauge::FrameRate, (frames - lastFrames) / seconds);
+  set(Gauge::DecodeRate, (instructions - lastInstructions) / seconds);
+
+  lastTime = now;
+  lastFrames = frames;
+  lastInstructions = instructions;
+}
+
+bool Metrics::write() const {
+  return format == MetricsFormat::Prometheus ? writePrometheus()
+                                             : writeJsonLine();
+}
+
+// The exporter may read at any time: write aside, then rename over the file.
+bool Metrics::writePrometheus() const {
+  std::string labels = label.empty() ? "" : "{stream=\"" + label + "\"}";
+  std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream file(tmpPath, std::ios::trunc);
+    if (!file.is_open()) {
+      return false;
+    }
+    for (size_t i = 0; i < COUNTERS; ++i) {
+      file << "# HELP tricot_" << counterNames[i] << "_total " << counterHelp[i]
+           << "\n# TYPE tricot_" << counterNames[i] << "_total counter\n"
+           << "tricot_" << counterNames[i] << "_total" << labels << " "
+           << counters[i].load(std::memory_order_relaxed) << "\n";
+    }
+    for (size_t i = 0; i < GAUGES; ++i) {
+      file << "# HELP tricot_" << gaugeNames[i] << " " << gaugeHelp[i]
+           << "\n# TYPE tricot_" << gaugeNames[i] << " gauge\n"
+           << "tricot_" << gaugeNames[i] << labels << " "
+           << gauges[i].load(std::memory_order_relaxed) << "\n";
+    }
+    if (!file.good()) {
+      return false;
+    }
+  }
+  return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+bool Metrics::writeJsonLine() const {
+  std::ofstream file(path, std::ios::app);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  file << "{\"time\":" << std::time(nullptr);
+  if (!label.empty()) {
+    file << ",\"stream\":\"" << label << "\"";
+  }
+  for (size_t i = 0; i < COUNTERS; ++i) {
+    file << ",\"" << counterNames[i]
+         << "\":" << counters[i].load(std::memory_order_relaxed);
+  }
+  for (size_t i = 0; i < GAUGES; ++i) {
+    file << ",\"" << gaugeNames[i]
+         << "\":" << gauges[i].load(std::memory_order_relaxed);
+  }
+  file << "}\n";
+
+  return file.good();
+}
@@ -0,0 +1,158 @@
+#include "../include/pool.hpp"
+#include <algorithm>
+
+namespace {
+// Index of the queue owned by the current thread, if it is a worker
+thread_local size_t currentQueue = static_cast<size_t>(-1);
+} // namespace
+
+/**
+ * CONSTRUCTOR / DESTRUCTOR
+ */
+
+ThreadPool::ThreadPool(size_t threads) {
+  if (threads == 0) {
+    threads = 1;
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    queues.push_back(std::make_unique<Queue>());
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    workers.emplace_back(&ThreadPool::run, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopping = true;
+  }
+  sleepCond.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+/**
+ * TASKS
+ */
+
+// Workers push on their own deque, other threads spread tasks round-robin
+void ThreadPool::submit(Task task) {
+  size_t i = currentQueue < queues.size()
+                 ? currentQueue
+                 : nextQueue.fetch_add(1, std::memory_order_relaxed) %
+                       queues.size();
+  {
+    std::lock_guard<std::mutex> lock(queues[i]->mutex);
+    queues[i]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    pending.fetch_add(1, std::memory_order_release);
+  }
+  sleepCond.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t n, const std::function<void(size_t)> &fn) {
+  if (n == 0) {
+    return;
+  }
+
+  // Helpers may outlive this call if they are dequeued late: they only hold
+  // the shared state and bail out once every index is taken.
+  struct State {
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    const std::function<void(size_t)> *fn;
+    std::mutex mutex;
+    std::condition_variable cond;
+  };
+  auto state = std::make_shared<State>();
+  state->fn = &fn;
+
+  auto work = [state, n] {
+    size_t i;
+    while ((i = state->next.fetch_add(1, std::memory_order_relaxed)) < n) {
+      (*state->fn)(i);
+      if (state->done.fetch_add(1, std::memory_order_acq_rel) + 1 == n) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->cond.notify_all();
+      }
+    }
+  };
+
+  size_t helpers = std::min(n - 1, queues.size());
+  for (size_t i = 0; i < helpers; ++i) {
+    submit(work);
+  }
+  work();
+
+  // Indices still running elsewhere: help with other tasks meanwhile, and
+  // sleep once there is nothing left to steal. Every index is taken by now,
+  // so the threads running them will wake us up.
+  size_t self = currentQueue < queues.size() ? currentQueue : 0;
+  auto finished = [&state, n] {
+    return state->done.load(std::memory_order_acquire) >= n;
+  };
+  while (!finished()) {
+    if (!tryRun(self)) {
+      std::unique_lock<std::mutex> lock(state->mutex);
+      state->cond.wait(lock, finished);
+    }
+  }
+}
+
+size_t ThreadPool::size() const { return workers.size(); }
+
+/**
+ * WORKERS
+ */
+
+void ThreadPool::run(size_t self) {
+  currentQueue = self;
+  while (true) {
+    if (tryRun(self)) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    sleepCond.wait(lock, [this] {
+      return stopping || pending.load(std::memory_order_acquire) > 0;
+    });
+    if (stopping && pending.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+  }
+}
+
+// Own deque first (LIFO, still warm in cache), then steal the oldest task of
+// the other deques.
+bool ThreadPool::tryRun(size_t self) {
+  Task task;
+  bool found = pop(self, task, true);
+  for (size_t k = 1; !found && k < queues.size(); ++k) {
+    found = pop((self + k) % queues.size(), task, false);
+  }
+  if (!found) {
+    return false;
+  }
+  pending.fetch_sub(1, std::memory_order_acq_rel);
+  task();
+  return true;
+}
+
+bool ThreadPool::pop(size_t i, Task &task, bool back) {
+  std::lock_guard<std::mutex> lock(queues[i]->mutex);
+  std::deque<Task> &tasks = queues[i]->tasks;
+  if (tasks.empty()) {
+    return false;
+  }
+  if (back) {
+    task = std::move(tasks.back());
+    tasks.pop_back();
+  } else {
+    task = std::move(tasks.front());
+    tasks.pop_front();
+  }
+  return true;
+}
@@ -1,5 +1,14 @@
 #include "../include/reader.hpp"
 
+// Overlay messages, built once instead of on every frame
+static const std::string lookingForHeaderText = "Looking for the header !!";
+static const std::string foundHeaderPartText = "Found a part of the header !";
+static const std::string foundHeaderText = "Found the whole header !";
+static const std::string detectingColorsText =
+    "Detecing the colors in the header";
+static const std::string readyText =
+    "Finished. Now ready to interpret the detected colors.";
+
 /**
  * CONSTRUCTOR / DESTRUCTOR
  */
@@ -12,6 +21,12 @@ VideoProcessor::VideoProcessor() {
   if (!verbose || (verbose && verbose != MODIFY_HEADER_CALIBRATION)) {
     loadAdjustments();
   }
+
+  // Scratch buffers for the per-frame kernels, reused from frame to frame
+  grayRoi.create(ROI_HEIGHT, ROI_WIDTH, CV_8U);
+  magnifiedBody.create(BODY_ROI_HEIGHT * 4, BODY_ROI_WIDTH * 4, CV_8UC3);
+  overlayText.reserve(64);
+  command.reserve(COMMAND_CAPACITY);
 }
 
 /**
@@ -19,68 +34,265 @@ VideoProcessor::VideoProcessor() {
  */
 
 void VideoProcessor::processVideoStream() {
+  if (!open()) {
+    return;
+  }
+
+  while (step()) {
+    // Replays run as fast as the display allows
+    int key = cv::waitKey(frameSource ? 1 : 25);
+    if (key == 27 || !handleKey(key)) {
+      break;
+    }
+    show();
+  }
+
+  close();
+  cv::destroyAllWindows();
+}
+
+bool VideoProcessor::open() {
   if (verbose && verbose == MODIFY_HEADER_CALIBRATION) {
     if (!openVideoStream()) {
-      return;
+      return false;
     }
   } else if (!openVideoStream() ||
              !loadTemplates("templates/header/instructions", headerTemplates) ||
              !loadTemplates("templates/header/border", headerBorderTemplates) ||
              !loadTemplates("templates/body", endTemplate)) {
-    return;
+    return false;
   }
+  if (!metricsPath.empty()) {
+    metrics.start(metricsPath, streamName);
+  }
+  dumper.setFormat(dumpFormat);
+
+  videoWindow = windowName("Video Stream");
+  separatorWindow = windowName("Separator Color");
+  magnifiedWindow = windowName("Magnified Body ROI");
+  return true;
+}
 
-  cv::Mat frame;
-  while (true) {
-    if (!cap.read(frame)) {
+// Reads and decodes one frame. Does not touch the GUI, so that several
+// streams can be stepped from worker threads.
+bool VideoProcessor::step() {
+  // Source frames are never written to: they are adjusted into `frame`
+  cv::Mat &input = frameSource ? sourceFrame : frame;
+  if (!readFrame(input)) {
+    // Recordings and generated streams simply end
+    if (!frameSource) {
       std::cerr << "Error: could not read frame." << std::endl;
-      break;
     }
+    return false;
+  }
+  metrics.increment(Counter::FramesRead);
+  if (recorder.isOpen()) {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    recorder.append(
+        input(roi),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+  }
+  adjustFrame(input, frame);
 
-    if (!verbose || (verbose && verbose != MODIFY_HEADER_CALIBRATION)) {
-      if (colors.size() < 8) {
-        detectTemplate(frame, headerBorderTemplates);
-      } else {
-        processBody(frame);
-      }
-      cv::rectangle(frame, roi, cv::Scalar(255, 0, 0), 2);
+  if (!verbose || (verbose && verbose != MODIFY_HEADER_CALIBRATION)) {
+    if (colors.size() >= 8 || restoreHeaderCache(frame)) {
+      processBody(frame);
+    } else {
+      detectTemplate(frame, headerBorderTemplates);
     }
+    cv::rectangle(frame, roi, cv::Scalar(255, 0, 0), 2);
+  }
 
-    int key = cv::waitKey(25);
-    if (key == 27) {
-      break;
-    } else if (verbose) {
-      printVerboseCalibration(frame);
-      adjustFrame(frame);
-      if (verbose == MODIFY_HEADER_CALIBRATION &&
-          handleCalibrationControl(key, frame)) {
-        break;
-      }
+  return true;
+}
+
+// Returns false when the stream should stop
+bool VideoProcessor::handleKey(int key) {
+  if (verbose) {
+    printVerboseCalibration(frame);
+    if (verbose == MODIFY_HEADER_CALIBRATION &&
+        handleCalibrationControl(key, frame)) {
+      return false;
     }
+  }
+  return true;
+}
+
+// GUI calls, from the main thread only
+void VideoProcessor::show() {
+  show(DisplayFrames{frame, separatorDisplay, magnifiedBody, isBodyDisplayed});
+}
+
+void VideoProcessor::show(const DisplayFrames &display) {
+  if (display.isBodyDisplayed) {
+    cv::namedWindow(separatorWindow, cv::WINDOW_NORMAL);
+    cv::resizeWindow(separatorWindow, display.separator.cols,
+                     display.separator.rows);
+    cv::moveWindow(separatorWindow, 1024, 0);
+    cv::imshow(separatorWindow, display.separator);
+
+    cv::moveWindow(magnifiedWindow, 1024, 256);
+    cv::imshow(magnifiedWindow, display.magnified);
+  }
+
+  cv::imshow(videoWindow, display.frame);
+}
+
+// The buffers keep their size from frame to frame, copies reuse them
+void VideoProcessor::publish() {
+  frame.copyTo(displayBack.frame);
+  if (isBodyDisplayed) {
+    separatorDisplay.copyTo(displayBack.separator);
+    magnifiedBody.copyTo(displayBack.magnified);
+  }
+  displayBack.isBodyDisplayed = isBodyDisplayed;
+
+  std::lock_guard<std::mutex> lock(displayMutex);
+  std::swap(displayBack, displayReady);
+  isDisplayReady = true;
+}
 
-    cv::imshow("Video Stream", frame);
+// Keeps the windows as they are until a new frame is published
+void VideoProcessor::showPublished() {
+  {
+    std::lock_guard<std::mutex> lock(displayMutex);
+    if (!isDisplayReady) {
+      return;
+    }
+    std::swap(displayReady, displayFront);
+    isDisplayReady = false;
   }
+  show(displayFront);
+}
 
+void VideoProcessor::close() {
+  metrics.stop();
+  if (size_t lost = dumper.dropped()) {
+    std::cerr << "Warning: " << lost << " debug images dropped"
+              << (streamName.empty() ? "" : " on " + streamName) << std::endl;
+  }
+  recorder.close();
+  frameSource.reset();
   cap.release();
-  cv::destroyAllWindows();
+}
+
+std::string VideoProcessor::windowName(const std::string &base) const {
+  return streamName.empty() ? base : base + " - " + streamName;
 }
 
 bool VideoProcessor::openVideoStream() {
-  cap.open(0);
+  if (!replayPath.empty()) {
+    auto replay = std::make_unique<FrameReplay>();
+    if (!replay->open(replayPath)) {
+      return false;
+    }
+    LOG_INFO("Replaying %zu frames of %dx%d", replay->frameCount(),
+             replay->roi().width, replay->roi().height);
+    // Frames were recorded before calibration, replay them with the one
+    // they were captured with
+    if (replay->calibration(currentBrightness, currentContrast)) {
+      LOG_INFO("Recorded calibration: brightness %.2f, contrast %.2f",
+               currentBrightness, currentContrast);
+    }
+    frameSource = std::move(replay);
+  }
+  if (frameSource) {
+    // Recorded and generated frames only hold the roi, already in BGR
+    roi = frameSource->roi();
+    captureMode = CaptureMode::BGR;
+    return openRecorder();
+  }
+
+  // A number is a camera index, anything else a file or URL
+  bool isDevice = !source.empty() &&
+                  std::all_of(source.begin(), source.end(), ::isdigit);
+  if (isDevice) {
+    cap.open(std::stoi(source));
+  } else {
+    cap.open(source);
+  }
   if (!cap.isOpened()) {
-    std::cerr << "Error: could not open camera." << std::endl;
+    std::cerr << "Error: could not open camera " << source << "." << std::endl;
     return false;
   }
 
   cap.set(cv::CAP_PROP_FRAME_WIDTH, FRAME_WIDTH);
   cap.set(cv::CAP_PROP_FRAME_HEIGHT, FRAME_HEIGHT);
 
-  std::cout << "Frame size: " << cap.get(cv::CAP_PROP_FRAME_WIDTH) << "x"
-            << cap.get(cv::CAP_PROP_FRAME_HEIGHT) << std::endl;
+  if (captureMode == CaptureMode::YUYV) {
+    cap.set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('Y', 'U', 'Y', 'V'));
+    if (!cap.set(cv::CAP_PROP_CONVERT_RGB, 0)) {
+      std::cerr << "Warning: backend cannot deliver raw YUYV, using BGR."
+                << std::endl;
+      captureMode = CaptureMode::BGR;
+    }
+  }
+
+  LOG_INFO("Frame size: %gx%g", cap.get(cv::CAP_PROP_FRAME_WIDTH),
+           cap.get(cv::CAP_PROP_FRAME_HEIGHT));
+
+  return openRecorder();
+}
+
+bool VideoProcessor::openRecorder() {
+  if (recordPath.empty()) {
+    return true;
+  }
+  if (captureMode == CaptureMode::YUYV) {
+    std::cerr << "Warning: the recording holds the roi converted to BGR, its "
+                 "replay searches the header on gray, not on the camera luma."
+              << std::endl;
+  }
+  return recorder.open(recordPath, roi.size(), CV_8UC3, currentBrightness,
+                       currentContrast);
+}
+
+// In YUYV mode the camera buffer is kept as is: the luma of the roi is used
+// for template matching, and only the roi is converted to BGR for the color
+// analysis and the display. The rest of the frame stays black.
+bool VideoProcessor::readFrame(cv::Mat &frame) {
+  if (frameSource) {
+    return frameSource->read(frame);
+  }
+  if (captureMode != CaptureMode::YUYV) {
+    return cap.read(frame);
+  }
+
+  if (!cap.read(rawFrame)) {
+    return false;
+  }
+  if (rawFrame.type() != CV_8UC2 || rawFrame.cols != FRAME_WIDTH ||
+      rawFrame.rows != FRAME_HEIGHT) {
+    std::cerr << "Warning: camera did not return YUYV frames, using BGR."
+              << std::endl;
+    captureMode = CaptureMode::BGR;
+    cap.set(cv::CAP_PROP_CONVERT_RGB, 1);
+    return cap.read(frame);
+  }
+
+  if (frame.size() != rawFrame.size() || frame.type() != CV_8UC3) {
+    frame = cv::Mat::zeros(rawFrame.size(), CV_8UC3);
+  }
+  cv::Mat rawRoi = rawFrame(roi);
+  cv::Mat bgrRoi = frame(roi);
+  cv::cvtColor(rawRoi, bgrRoi, cv::COLOR_YUV2BGR_YUYV);
+  cv::extractChannel(rawRoi, roiLuma, 0);
 
   return true;
 }
 
+void VideoProcessor::setFrameSource(std::unique_ptr<FrameSource> source) {
+  frameSource = std::move(source);
+}
+
+const std::string &VideoProcessor::getCommand() const { return command; }
+
+bool VideoProcessor::isDecodingBody() const { return colors.size() >= 8; }
+
+size_t VideoProcessor::getMatchingMismatches() const {
+  return matchingMismatches;
+}
+
 /**
  * TEMPLATES
  */
@@ -106,49 +318,74 @@ bool VideoProcessor::loadTemplates(const std::string &path, Template &templ) {
     return false;
   }
 
-  std::cout << "(verbose) Loaded templates: " << path << std::endl;
-  for (Template::iterator it = templ.begin(); it != templ.end(); ++it) {
-    std::cout << it->first << "\t";
+  if (Logger::instance().enabled(LogLevel::Debug)) {
+    std::string names;
+    for (Template::iterator it = templ.begin(); it != templ.end(); ++it) {
+      names += it->first + "\t";
+    }
+    LOG_DEBUG("(verbose) Loaded templates: %s\n%s", path.c_str(),
+              names.c_str());
   }
-  std::cout << std::endl;
 
   return true;
 }
 
-void VideoProcessor::detectTemplate(cv::Mat &frame, Template &templs) {
-  cv::Mat roiFrame = frame(roi);
-  cv::Mat gray;
-  cv::cvtColor(roiFrame, gray, cv::COLOR_BGR2GRAY);
+// The roi as read by the template search
+cv::Mat VideoProcessor::roiToGray(const cv::Mat &frame) {
+  if (captureMode == CaptureMode::YUYV) {
+    return roiLuma;
+  }
+  cv::cvtColor(frame(roi), grayRoi, cv::COLOR_BGR2GRAY);
+  return grayRoi;
+}
 
-  std::map<std::string, cv::Point> detectedLocations;
+void VideoProcessor::detectTemplate(cv::Mat &frame, Template &templs) {
+  cv::Mat gray = roiToGray(frame);
 
-  printVerbose(frame, "Looking for the header !!");
+  for (auto &[name, detection] : detections) {
+    detection.found = false;
+  }
+  metrics.increment(Counter::HeaderDetectionsTried);
 
-  for (const auto &[name, templ] : templs) {
-    cv::Mat result;
-    double minVal, maxVal;
-    cv::Point minLoc, maxLoc;
+  printVerbose(frame, lookingForHeaderText);
 
-    cv::matchTemplate(gray, templ, result, cv::TM_CCOEFF_NORMED);
-    cv::minMaxLoc(result, &minVal, &maxVal, &minLoc, &maxLoc);
+  if (pool && pool->size() > 1 && parallelMatching) {
+    matchTemplatesTiled(gray, templs);
+    if (verifyMatching) {
+      verifyTiledMatches(gray, templs);
+    }
+  } else {
+    for (const auto &[name, templ] : templs) {
+      // Only allocated on the first frame
+      cv::Mat &result = matchResults[name];
+      Detection &detection = detections[name];
+
+      cv::matchTemplate(gray, templ, result, cv::TM_CCOEFF_NORMED);
+      cv::minMaxLoc(result, nullptr, &detection.score, nullptr,
+                    &detection.match);
+    }
+  }
 
-    if (maxVal > TEMPLATE_THRESHOLD) {
-      printVerbose(frame, "Found a part of the header !");
-      cv::Point actualLoc(roi.x + maxLoc.x, roi.y + maxLoc.y);
+  for (const auto &[name, templ] : templs) {
+    Detection &detection = detections[name];
+    if (detection.score > TEMPLATE_THRESHOLD) {
+      printVerbose(frame, foundHeaderPartText);
+      cv::Point actualLoc(roi.x + detection.match.x,
+                          roi.y + detection.match.y);
       cv::rectangle(
           frame, actualLoc,
           cv::Point(actualLoc.x + templ.cols, actualLoc.y + templ.rows),
           cv::Scalar(0, 255, 0), 2);
       cv::putText(frame, name, actualLoc, cv::FONT_HERSHEY_SIMPLEX, 0.5,
                   cv::Scalar(255, 255, 255), 2);
-      detectedLocations[name] = actualLoc;
+      detection.found = true;
+      detection.location = actualLoc;
     }
   }
 
-  if (detectedLocations.count("header_start") &&
-      detectedLocations.count("header_end")) {
-    cv::Point startLoc = detectedLocations["header_start"];
-    cv::Point endLoc = detectedLocations["header_end"];
+  if (detections["header_start"].found && detections["header_end"].found) {
+    cv::Point startLoc = detections["header_start"].location;
+    cv::Point endLoc = detections["header_end"].location;
 
     int offTop = 25;
     int offBottom = 55;
@@ -156,10 +393,11 @@ void VideoProcessor::detectTemplate(cv::Mat &frame, Template &templs) {
     int headerWidth = 120;
     int headerHeight = endLoc.y - startLoc.y - templs["header_end"].rows - off;
     // int x = startLoc.x;
-    int x = (FRAME_WIDTH / 2) - (headerWidth / 2);
+    int x = roi.x + (roi.width / 2) - (headerWidth / 2);
     int y = startLoc.y + templs["header_start"].rows + offTop;
 
-    printVerbose(frame, "Found the whole header !");
+    printVerbose(frame, foundHeaderText);
+    metrics.increment(Counter::HeaderDetectionsSucceeded);
 
     cv::Rect headerRoiRect(x, y, headerWidth, headerHeight);
     cv::rectangle(frame, headerRoiRect, cv::Scalar(0, 255, 255), 2);
@@ -169,6 +407,56 @@ void VideoProcessor::detectTemplate(cv::Mat &frame, Template &templs) {
     cv::Mat headerRoi = frame(headerRoiRect);
     processHeader(frame, headerRoi, x, y);
     bodyRoiPos = endLoc;
+    saveHeaderCache(gray, headerRoiRect);
+  }
+}
+
+// Splits every template search into horizontal tiles run on the pool. A
+// tile computes a band of result rows, so it reads that band of the image
+// plus templ.rows - 1 rows of overlap: each result value is computed from
+// exactly the same pixels as in a full match. Per-tile maxima are merged in
+// row order, keeping the first one on ties like cv::minMaxLoc does.
+void VideoProcessor::matchTemplatesTiled(const cv::Mat &gray,
+                                         Template &templs) {
+  matchJobs.clear();
+  for (const auto &[name, templ] : templs) {
+    Detection &detection = detections[name];
+    int rows = gray.rows - templ.rows + 1;
+    int cols = gray.cols - templ.cols + 1;
+    if (rows <= 0 || cols <= 0) {
+      detection.score = -1.0;
+      continue;
+    }
+
+    cv::Mat &result = matchResults[name];
+    result.create(rows, cols, CV_32F);
+
+    int tiles = std::clamp(rows / TEMPLATE_TILE_ROWS, 1,
+                           static_cast<int>(pool->size()));
+    for (int tile = 0; tile < tiles; ++tile) {
+      matchJobs.push_back({&templ, &result, &detection, tile,
+                           rows * tile / tiles, rows * (tile + 1) / tiles});
+    }
+  }
+  tileMatches.resize(matchJobs.size());
+
+  pool->parallelFor(matchJobs.size(), [&](size_t k) {
+    const MatchJob &job = matchJobs[k];
+    cv::Mat image = gray.rowRange(job.begin, job.end + job.templ->rows - 1);
+    cv::Mat result = job.result->rowRange(job.begin, job.end);
+
+    cv::matchTemplate(image, *job.templ, result, cv::TM_CCOEFF_NORMED);
+    cv::minMaxLoc(result, nullptr, &tileMatches[k].score, nullptr,
+                  &tileMatches[k].match);
+    tileMatches[k].match.y += job.begin;
+  });
+
+  for (size_t k = 0; k < matchJobs.size(); ++k) {
+    Detection &detection = *matchJobs[k].detection;
+    if (matchJobs[k].tile == 0 || tileMatches[k].score > detection.score) {
+      detection.score = tileMatches[k].score;
+      detection.match = tileMatches[k].match;
+    }
   }
 }
 
@@ -176,8 +464,6 @@ void VideoProcessor::detectTemplate(cv::Mat &frame, Template &templs) {
  * COLORS
  */
 
-const int threshold = 500;
-
 int VideoProcessor::colorDistanceBGR(const cv::Vec3b &color1,
                                      const cv::Vec3b &color2) {
   int dB = color1[0] - color2[0];
@@ -189,68 +475,60 @@ int VideoProcessor::colorDistanceBGR(const cv::Vec3b &color1,
 
 bool VideoProcessor::areColorsSimilar(const cv::Vec3b &color1,
                                       const cv::Vec3b &color2) {
-  return (colorDistanceBGR(color1, color2) < threshold ? true : false);
+  return (colorDistanceBGR(color1, color2) < colorThreshold ? true : false);
 }
 
 std::string VideoProcessor::findClosestColorKey(const cv::Vec3b &dominant) {
   std::string instruction;
+  int chosen = -1; // distance to the color of `instruction`
+  int best = std::numeric_limits<int>::max();
+  int secondBest = std::numeric_limits<int>::max();
 
-  std::cout << "-- Iterating through all the colors --" << std::endl;
+  LOG_DEBUG("-- Iterating through all the colors --");
   for (auto const &[key, color] : colors) {
-    bool similar = areColorsSimilar(dominant, color);
-    std::cout << "Distance between " << dominant << " and " << color << " is "
-              << colorDistanceBGR(dominant, color) << std::endl;
-    if (similar) {
-      instruction = key;
-      break;
+    int distance = colorDistanceBGR(dominant, color);
+    if (instruction.empty()) {
+      LOG_DEBUG("Distance between [%d, %d, %d] and [%d, %d, %d] is %d",
+                dominant[0], dominant[1], dominant[2], color[0], color[1],
+                color[2], distance);
+      if (areColorsSimilar(dominant, color)) {
+        instruction = key;
+        chosen = distance;
+      }
+    }
+    // Keep going to measure how ambiguous the palette is
+    if (distance < best) {
+      secondBest = best;
+      best = distance;
+    } else if (distance < secondBest) {
+      secondBest = distance;
     }
   }
 
+  metrics.set(Gauge::ColorDistanceBest, best);
+  if (colors.size() > 1) {
+    metrics.set(Gauge::ColorDistanceMargin, secondBest - best);
+  }
+  // The chosen key is the first similar color, not always the closest one
+  TRACE("{\"stream\":\"%s\",\"frame\":%llu,\"key\":\"%s\","
+        "\"distance\":%d,\"best\":%d,\"margin\":%d}",
+        streamName.c_str(),
+        static_cast<unsigned long long>(metrics.get(Counter::FramesRead)),
+        instruction.c_str(), chosen, best,
+        colors.size() > 1 ? secondBest - best : -1);
+
   return instruction;
 }
 
+cv::Vec3b VideoProcessor::getDominantColorBGR_KMeans(const cv::Mat &image) {
+  return getDominantColorBGR_KMeans(image, bodyKMeans);
+}
+
+// Center of the cluster with the most pixels
 cv::Vec3b VideoProcessor::getDominantColorBGR_KMeans(const cv::Mat &image,
-                                                     int k) {
+                                                     KMeans &kmeans) {
   CV_Assert(image.channels() == 3);
-
-  // Ensure the image is continuous
-  cv::Mat continuousImage;
-  if (!image.isContinuous()) {
-    continuousImage = image.clone();
-  } else {
-    continuousImage = image;
-  }
-
-  // Reshape the image to a 2D array of pixels
-  cv::Mat pixels = continuousImage.reshape(1, continuousImage.total());
-  pixels.convertTo(pixels, CV_32F);
-
-  // Define criteria and apply kmeans
-  cv::TermCriteria criteria(cv::TermCriteria::EPS + cv::TermCriteria::MAX_ITER,
-                            100, 0.2);
-  cv::Mat labels, centers;
-  cv::kmeans(pixels, k, labels, criteria, 10, cv::KMEANS_RANDOM_CENTERS,
-             centers);
-
-  // Find the cluster with the most pixels
-  std::vector<int> clusterSizes(k, 0);
-  for (int i = 0; i < labels.rows; ++i) {
-    clusterSizes[labels.at<int>(i)]++;
-  }
-
-  int dominantCluster =
-      std::distance(clusterSizes.begin(),
-                    std::max_element(clusterSizes.begin(), clusterSizes.end()));
-
-  // Return the color of the dominant cluster
-  cv::Vec3f dominantColor = centers.row(dominantCluster);
-
-  // To do : add some verbose when the dominantColor is 0, 255, 255 and
-  // print all relevant information about the KMeans
-
-  return cv::Vec3b(cv::saturate_cast<uchar>(dominantColor[0]),
-                   cv::saturate_cast<uchar>(dominantColor[1]),
-                   cv::saturate_cast<uchar>(dominantColor[2]));
+  return kmeans.center(kmeans.run(image));
 }
 
 cv::Vec3b VideoProcessor::getDominantColorBGR(const cv::Mat &image) {
@@ -274,10 +552,175 @@ cv::Vec3b VideoProcessor::getDominantColorBGR(const cv::Mat &image) {
                    maxIdx[2] * 256 / rBins);
 }
 
+// Counts the templates where the tiled search picked another location than a
+// full match, or a score more than TEMPLATE_SCORE_TOLERANCE away
+void VideoProcessor::verifyTiledMatches(const cv::Mat &gray,
+                                        const Template &templs) {
+  for (const auto &[name, templ] : templs) {
+    if (templ.rows > gray.rows || templ.cols > gray.cols) {
+      continue;
+    }
+    const Detection &detection = detections[name];
+    cv::Mat result;
+    double score;
+    cv::Point match;
+    cv::matchTemplate(gray, templ, result, cv::TM_CCOEFF_NORMED);
+    cv::minMaxLoc(result, nullptr, &score, nullptr, &match);
+    if (match != detection.match ||
+        std::abs(score - detection.score) > TEMPLATE_SCORE_TOLERANCE) {
+      ++matchingMismatches;
+      std::cerr << "Error: tiled match of " << name << " at "
+                << detection.match << " (" << detection.score
+                << "), full match at " << match << " (" << score << ")"
+                << std::endl;
+    }
+  }
+}
+
+/**
+ * HEADER CACHE
+ */
+
+// Live sources only: generated and recorded streams, and the verbose modes,
+// always go through the full detection
+bool VideoProcessor::isHeaderCacheEnabled() const {
+  return !headerCachePath.empty() && !frameSource && !verbose;
+}
+
+// Each bit tells whether a cell of the 8x8 downscaled region is brighter
+// than the mean
+uint64_t VideoProcessor::averageHash(const cv::Mat &gray) {
+  cv::Mat small;
+  cv::resize(gray, small, cv::Size(8, 8), 0, 0, cv::INTER_AREA);
+  double mean = cv::mean(small)[0];
+
+  uint64_t hash = 0;
+  for (int i = 0; i < 64; ++i) {
+    if (small.at<uchar>(i / 8, i % 8) > mean) {
+      hash |= 1ULL << i;
+    }
+  }
+  return hash;
+}
+
+void VideoProcessor::saveHeaderCache(const cv::Mat &gray,
+                                     const cv::Rect &header) {
+  if (!isHeaderCacheEnabled() || colors.size() != HEADER_SECTIONS) {
+    return;
+  }
+  cv::Rect rect = (header - roi.tl()) & cv::Rect(0, 0, gray.cols, gray.rows);
+  if (rect.empty()) {
+    return;
+  }
+
+  HeaderCache cache;
+  cache.magic = HEADER_CACHE_MAGIC;
+  cache.fingerprint = averageHash(gray(rect));
+  cache.header[0] = rect.x;
+  cache.header[1] = rect.y;
+  cache.header[2] = rect.width;
+  cache.header[3] = rect.height;
+  cache.bodyRoiPos[0] = bodyRoiPos.x - roi.x;
+  cache.bodyRoiPos[1] = bodyRoiPos.y - roi.y;
+  size_t i = 0;
+  for (const auto &[key, color] : colors) {
+    cache.keys[i] = key.front();
+    for (int ch = 0; ch < 3; ++ch) {
+      cache.colors[i][ch] = color[ch];
+    }
+    ++i;
+  }
+  for (int ch = 0; ch < 3; ++ch) {
+    cache.separator[ch] = separatorColorBGR[ch];
+  }
+  saveValue(headerCachePath.c_str(), cache);
+}
+
+// Tried on the first HEADER_CACHE_ATTEMPTS frames, while the full detection
+// runs: cameras often start with black or still adjusting frames. The cached
+// header is reused when its region still has the same fingerprint and the
+// end border is found next to where it was, so decoding starts on that frame.
+bool VideoProcessor::restoreHeaderCache(const cv::Mat &frame) {
+  if (headerCacheAttempts >= HEADER_CACHE_ATTEMPTS || !isHeaderCacheEnabled()) {
+    return false;
+  }
+  if (headerCacheAttempts++ == 0) {
+    loadValue(headerCachePath.c_str(), headerCache);
+  }
+
+  auto end = headerBorderTemplates.find("header_end");
+  if (headerCache.magic != HEADER_CACHE_MAGIC ||
+      end == headerBorderTemplates.end()) {
+    // Nothing worth retrying
+    headerCacheAttempts = HEADER_CACHE_ATTEMPTS;
+    return false;
+  }
+
+  cv::Point endLoc;
+  if (!verifyHeaderCache(roiToGray(frame), end->second, endLoc)) {
+    if (headerCacheAttempts == HEADER_CACHE_ATTEMPTS) {
+      LOG_INFO("Header changed since the last run, detecting it again");
+    }
+    return false;
+  }
+
+  const HeaderCache &cache = headerCache;
+  colors.clear();
+  for (int i = 0; i < HEADER_SECTIONS; ++i) {
+    colors[std::string(1, cache.keys[i])] = cv::Vec3b(
+        cache.colors[i][0], cache.colors[i][1], cache.colors[i][2]);
+  }
+  separatorColorBGR =
+      cv::Vec3b(cache.separator[0], cache.separator[1], cache.separator[2]);
+  bodyRoiPos = roi.tl() + endLoc;
+  LOG_INFO("Header restored from %s after %d frames", headerCachePath.c_str(),
+           headerCacheAttempts);
+  headerCacheAttempts = HEADER_CACHE_ATTEMPTS;
+  return true;
+}
+
+// On success, endLoc is the end border position in roi coordinates
+bool VideoProcessor::verifyHeaderCache(const cv::Mat &gray,
+                                       const cv::Mat &templ,
+                                       cv::Point &endLoc) {
+  const HeaderCache &cache = headerCache;
+  cv::Rect bounds(0, 0, gray.cols, gray.rows);
+  cv::Rect header(cache.header[0], cache.header[1], cache.header[2],
+                  cache.header[3]);
+  if (header.empty() || (header & bounds) != header) {
+    return false;
+  }
+  uint64_t changed = averageHash(gray(header)) ^ cache.fingerprint;
+  if (std::bitset<64>(changed).count() > HEADER_HASH_MAX_DISTANCE) {
+    return false;
+  }
+
+  // Narrow check: the end border, around its cached position
+  cv::Rect window =
+      cv::Rect(cache.bodyRoiPos[0] - HEADER_VERIFY_MARGIN,
+               cache.bodyRoiPos[1] - HEADER_VERIFY_MARGIN,
+               templ.cols + 2 * HEADER_VERIFY_MARGIN,
+               templ.rows + 2 * HEADER_VERIFY_MARGIN) &
+      bounds;
+  if (window.width < templ.cols || window.height < templ.rows) {
+    return false;
+  }
+  cv::Mat result;
+  double score;
+  cv::Point match;
+  cv::matchTemplate(gray(window), templ, result, cv::TM_CCOEFF_NORMED);
+  cv::minMaxLoc(result, nullptr, &score, nullptr, &match);
+  if (score <= TEMPLATE_THRESHOLD) {
+    return false;
+  }
+
+  endLoc = window.tl() + match;
+  return true;
+}
+
 /**
  * PROCESS
  */
-#include <ctime>
 void VideoProcessor::processHeader(cv::Mat &frame, cv::Mat &headerRoi, int x,
                                    int y) {
   std::vector<std::string> instructions = {"+", "-", "<", ">",
@@ -287,43 +730,60 @@ void VideoProcessor::processHeader(cv::Mat &frame, cv::Mat &headerRoi, int x,
   int width = headerRoi.cols;
   int height = headerRoi.rows / colorsNb;
 
-  printVerbose(frame, "Detecing the colors in the header");
-
-  separatorColorBGR = getDominantColorBGR_KMeans(headerRoi);
+  printVerbose(frame, detectingColorsText);
+
+  // The sections, and the whole header for the separator color, are analysed
+  // in parallel before anything is drawn on them. Each task has its own
+  // k-means, so the colors do not depend on the thread count.
+  std::array<cv::Vec3b, HEADER_SECTIONS + 1> dominantColors;
+  parallelFor(colorsNb + 1, [&](size_t i) {
+    cv::Mat region = i < colorsNb
+                         ? headerRoi(cv::Rect(0, height * i, width, height))
+                         : headerRoi;
+    dominantColors[i] = getDominantColorBGR_KMeans(region, headerKMeans[i]);
+  });
+  separatorColorBGR = dominantColors[colorsNb];
+
+  // Verbose : the comparison images are built by the dumper thread
+  cv::Mat header = saveImages ? headerRoi.clone() : cv::Mat();
   // Save as image the separator color for verbose purposes
-  saveSeparatorColor(headerRoi, width, height);
+  saveSeparatorColor(width, height);
 
-  for (int i = 0; i < colorsNb; ++i) {
-    cv::Rect dividedHeaderRect(0, height * i, width, height);
+  for (size_t i = 0; i < colorsNb; ++i) {
+    cv::Vec3b dominantColor = dominantColors[i];
+    colors[instructions[i]] = dominantColor;
     cv::rectangle(frame, cv::Rect(x, y + (height * i), width, height),
                   cv::Scalar(255, 0, 255), 2);
-    cv::Mat dividedHeader = headerRoi(dividedHeaderRect);
-
-    cv::Vec3b dominantColor = getDominantColorBGR_KMeans(dividedHeader);
-    colors[instructions[i]] = dominantColor;
 
-    // Verbose : show detected colors
-    cv::Mat comparisonMat(height, width * 2, dividedHeader.type());
-    dividedHeader.copyTo(comparisonMat(cv::Rect(0, 0, width, height)));
-    comparisonMat(cv::Rect(width, 0, width, height)) =
-        cv::Scalar(dominantColor[0], dominantColor[1], dominantColor[2]);
-    const std::string name = "header_section_" + std::to_string(i);
-    // Show the images
-    // cv::imshow(name, comparisonMat);
-    // cv::moveWindow(name, 0, i * 1.5 * height);
-    // Save the image
-    saveImage(name, comparisonMat, "assets/header/");
+    if (!saveImages) {
+      continue;
+    }
+    saveImage(
+        "header_section_" + std::to_string(i),
+        [header, i, width, height, dominantColor]() {
+          cv::Mat dividedHeader = header(cv::Rect(0, height * i, width, height));
+          cv::Mat comparisonMat(height, width * 2, dividedHeader.type());
+          dividedHeader.copyTo(comparisonMat(cv::Rect(0, 0, width, height)));
+          comparisonMat(cv::Rect(width, 0, width, height)) = cv::Scalar(
+              dominantColor[0], dominantColor[1], dominantColor[2]);
+          return comparisonMat;
+        },
+        "assets/header/");
   }
 
   saveImage("header2", frame, "assets/header/");
   saveImage("header3", headerRoi, "assets/header/");
 }
 
-void VideoProcessor::saveSeparatorColor(cv::Mat &roi, int width, int height) {
-  cv::Mat frame(height, width, roi.type());
-  frame(cv::Rect(0, 0, width, height)) = cv::Scalar(
-      separatorColorBGR[0], separatorColorBGR[1], separatorColorBGR[2]);
-  saveImage("separator_color", frame, "assets/header/");
+void VideoProcessor::saveSeparatorColor(int width, int height) {
+  cv::Vec3b color = separatorColorBGR;
+  saveImage(
+      "separator_color",
+      [color, width, height]() {
+        return cv::Mat(height, width, CV_8UC3,
+                       cv::Scalar(color[0], color[1], color[2]));
+      },
+      "assets/header/");
 }
 
 // Pour avoir la couleur de separation, on pourrait aussi prendre faire un
@@ -337,11 +797,9 @@ void VideoProcessor::processBody(cv::Mat &frame) {
     exit(0);
     return;
   }
-  printVerbose(frame, "Finished. Now ready to interpret the detected colors.");
+  printVerbose(frame, readyText);
   // Draw body ROI
-  int x = FRAME_WIDTH / 2;
-  int y = bodyRoiPos.y + 16;
-  cv::Rect bodyRoiRect(x, y, BODY_ROI_WIDTH, BODY_ROI_HEIGHT);
+  cv::Rect bodyRoiRect = getBodyRoiRect();
   cv::rectangle(frame, bodyRoiRect, cv::Scalar(0, 255, 255), 2);
 
   // Define body ROI
@@ -352,12 +810,15 @@ void VideoProcessor::processBody(cv::Mat &frame) {
 
   // RGB Dominant Color
   cv::Vec3b dominantColorBGR = getDominantColorBGR_KMeans(bodyRoi);
+  metrics.increment(Counter::BodyClassifications);
 
   // Initialize the separatorColor on the first time
   if (command.empty() && !isSeparatorColorSet) {
-    // Ca key'est du gros bricolage mdr
-    while (areColorsSimilar(dominantColorBGR, cv::Vec3b(0, 255, 255))) {
-      dominantColorBGR = getDominantColorBGR_KMeans(bodyRoi);
+    // The yellow outline of the body ROI may win, the clustering is
+    // deterministic so take the next largest cluster instead of rerunning it
+    if (areColorsSimilar(dominantColorBGR, cv::Vec3b(0, 255, 255))) {
+      dominantColorBGR = bodyKMeans.center(bodyKMeans.largest(
+          bodyKMeans.largest()));
     }
     separatorColorBGR = dominantColorBGR;
     isSeparatorColorSet = true;
@@ -367,81 +828,122 @@ void VideoProcessor::processBody(cv::Mat &frame) {
   // Verbose: draw separatorColor on the top-right of the screen
   const int colorWindowWidth = 128;
   const int colorWindowHeight = 64;
-  cv::Mat colorWindow(colorWindowHeight, colorWindowWidth, CV_8UC3,
-                      separatorColorBGR);
-  const std::string windowName = "Separator Color";
-  cv::namedWindow(windowName, cv::WINDOW_NORMAL);
-  cv::resizeWindow(windowName, colorWindowWidth, colorWindowHeight);
-  cv::moveWindow(windowName, 1024, 0);
-  cv::imshow(windowName, colorWindow);
+  separatorDisplay.create(colorWindowHeight, colorWindowWidth, CV_8UC3);
+  separatorDisplay = cv::Scalar(separatorColorBGR[0], separatorColorBGR[1],
+                                separatorColorBGR[2]);
+  isBodyDisplayed = true;
 
   if (lookForColor) {
     std::string instruction = findClosestColorKey(dominantColorBGR);
     if (!instruction.empty()) {
-      std::cout << "(verbose) Found new color: instruction: "
-                << instruction.front() << std::endl;
+      LOG_INFO("(verbose) Found new color: instruction: %c",
+               instruction.front());
       command.push_back(instruction.front());
+      metrics.increment(Counter::InstructionsEmitted);
       lookForColor = false;
     }
   } else {
     // Check ending condition here
 
     // Are we looking at the `separatorColor` ?
-    std::cout << "Now looking for separator color:"
-              << "\nseparator: " << separatorColorBGR
-              << "\ncurrent: " << dominantColorBGR << std::endl;
+    LOG_DEBUG("Now looking for separator color:\nseparator: [%d, %d, %d]\n"
+              "current: [%d, %d, %d]",
+              separatorColorBGR[0], separatorColorBGR[1], separatorColorBGR[2],
+              dominantColorBGR[0], dominantColorBGR[1], dominantColorBGR[2]);
+    int distance = colorDistanceBGR(dominantColorBGR, separatorColorBGR);
     bool similar = areColorsSimilar(dominantColorBGR, separatorColorBGR);
+    metrics.set(Gauge::SeparatorDistance, distance);
+    TRACE("{\"stream\":\"%s\",\"frame\":%llu,\"key\":\"%s\","
+          "\"distance\":%d}",
+          streamName.c_str(),
+          static_cast<unsigned long long>(metrics.get(Counter::FramesRead)),
+          similar ? "separator" : "", distance);
     if (similar) {
-      std::cout << "Apparently, we are currently looking at a color similar to "
-                   "separator color !"
-                << "\ndistance: "
-                << colorDistanceBGR(dominantColorBGR, separatorColorBGR)
-                << "\nseparator: " << separatorColorBGR
-                << "\ncurrent: " << dominantColorBGR << std::endl;
+      LOG_DEBUG("Apparently, we are currently looking at a color similar to "
+                "separator color !\ndistance: %d",
+                distance);
       lookForColor = true;
     }
   }
 }
 
+cv::Rect VideoProcessor::getBodyRoiRect() const {
+  int x = roi.x + roi.width / 2;
+  int y = bodyRoiPos.y + 16;
+  return cv::Rect(x, y, BODY_ROI_WIDTH, BODY_ROI_HEIGHT);
+}
+
 /**
  * UTILS
  */
 
+// Shown by show()
 void VideoProcessor::verboseMagnifyImage(const cv::Mat &img, int n) {
-  cv::Mat magnified;
-  cv::resize(img, magnified, cv::Size(), n, n, cv::INTER_NEAREST);
-
-  const std::string name = "Magnified Body ROI";
-  cv::moveWindow(name, 1024, 256);
-  cv::imshow(name, magnified);
+  cv::resize(img, magnifiedBody, cv::Size(), n, n, cv::INTER_NEAREST);
 }
 
+// cv::putText allocates on every call: each banner is rendered once, then
+// copied onto the frames
 void VideoProcessor::printVerbose(cv::Mat &frame, const std::string &text) {
+  if (!drawOverlays) {
+    return;
+  }
   const int x = 10;
   const int y = 10;
   const int height = 64;
-  const int width = FRAME_WIDTH - (x + y);
+  const int width = frame.cols - (x + y);
 
-  cv::rectangle(frame, cv::Rect(x, y, width, height), cv::Scalar(255, 255, 255),
-                3);
-  cv::rectangle(frame, cv::Rect(x, y, width, height), cv::Scalar(0, 0, 0), -1);
-  cv::Point textOrg(x + 5, y + 40);
-  cv::putText(frame, text, textOrg, cv::FONT_HERSHEY_SIMPLEX, 1,
-              cv::Scalar(255, 255, 255), 2);
+  // The white outline is 3 pixels wide, centered on the box edges
+  cv::Rect area(x - 1, y - 1, width + 2, height + 2);
+  if ((area & cv::Rect(0, 0, frame.cols, frame.rows)) != area) {
+    return;
+  }
+  cv::Mat &banner = banners[&text];
+  if (banner.size() != area.size()) {
+    banner.create(area.size(), CV_8UC3);
+    banner = cv::Scalar(255, 255, 255);
+    cv::rectangle(banner, cv::Rect(1, 1, width, height), cv::Scalar(0, 0, 0),
+                  -1);
+    cv::Point textOrg(1 + 5, 1 + 40);
+    cv::putText(banner, text, textOrg, cv::FONT_HERSHEY_SIMPLEX, 1,
+                cv::Scalar(255, 255, 255), 2);
+  }
+  banner.copyTo(frame(area));
 }
 
+// Debug dumps go through the background writer, they never stall a frame
 void VideoProcessor::saveImage(const std::string &name, cv::Mat &img,
                                const std::string &path) {
-  std::time_t result = std::time(nullptr);
-  std::stringstream ss;
-  ss << std::put_time(std::localtime(&result), "%Y%m%d_%H%M");
-  std::string timestamp = ss.str();
+  if (!saveImages) {
+    return;
+  }
+  // Each stream gets its own folder
+  dumper.push(name, img,
+              streamName.empty() ? path : path + streamName + "/");
+}
 
-  std::string filename = name + ".png";
-  std::string dirname = path + timestamp;
-  std::filesystem::create_directory(dirname);
+void VideoProcessor::saveImage(const std::string &name, DumpRenderer render,
+                               const std::string &path) {
+  if (!saveImages) {
+    return;
+  }
+  dumper.push(name, std::move(render),
+              streamName.empty() ? path : path + streamName + "/");
+}
 
-  cv::imwrite(dirname + "/" + filename, img);
+// On the shared pool when there is one, on OpenCV's threads otherwise
+void VideoProcessor::parallelFor(size_t n,
+                                 const std::function<void(size_t)> &fn) {
+  if (pool) {
+    pool->parallelFor(n, fn);
+    return;
+  }
+  cv::parallel_for_(cv::Range(0, static_cast<int>(n)),
+                    [&](const cv::Range &range) {
+                      for (int i = range.start; i < range.end; ++i) {
+                        fn(i);
+                      }
+                    });
 }
 
 /**
@@ -458,18 +960,61 @@ void VideoProcessor::saveCurrentAdjustments() const {
   saveValue(CONTRAST_FILE, currentContrast);
 }
 
-void VideoProcessor::adjustFrame(cv::Mat &frame) const {
-  // First adjust contrast
-  frame.convertTo(frame, -1, currentContrast, 0);
-  // Then adjust brightness (using beta parameter of convertTo)
-  double beta =
-      (currentBrightness - 1.0) * 100; // Scale brightness for better control
-  frame.convertTo(frame, -1, 1.0, beta);
+// Contrast then brightness, folded into a single 256 entries table. Only
+// rebuilt when the calibration values change.
+void VideoProcessor::updateAdjustmentLut() {
+  // Scale brightness for better control
+  double beta = (currentBrightness - 1.0) * 100;
+
+  adjustmentLut.create(1, 256, CV_8U);
+  uchar *lut = adjustmentLut.ptr<uchar>();
+  isAdjustmentIdentity = true;
+  for (int i = 0; i < 256; ++i) {
+    uchar contrasted = cv::saturate_cast<uchar>(i * currentContrast);
+    lut[i] = cv::saturate_cast<uchar>(contrasted + beta);
+    isAdjustmentIdentity = isAdjustmentIdentity && lut[i] == i;
+  }
+
+  lutBrightness = currentBrightness;
+  lutContrast = currentContrast;
 }
 
-bool VideoProcessor::handleCalibrationControl(const int &key, cv::Mat &frame) {
-  bool frameModified = false;
+// Camera frames are adjusted in place, only the regions read by the detector
+// (roi, and the body once the header is known), in one pass. Source frames
+// only hold the roi and may be read-only mappings: the table is applied, or
+// the frame copied, into the reused `frame` buffer instead.
+void VideoProcessor::adjustFrame(const cv::Mat &source, cv::Mat &frame) {
+  if (adjustmentLut.empty() || lutBrightness != currentBrightness ||
+      lutContrast != currentContrast) {
+    updateAdjustmentLut();
+  }
+  if (source.data != frame.data) {
+    if (isAdjustmentIdentity) {
+      source.copyTo(frame);
+    } else {
+      cv::LUT(source, adjustmentLut, frame);
+    }
+    return;
+  }
+  if (isAdjustmentIdentity) {
+    return;
+  }
+
+  cv::Rect region = roi;
+  if (colors.size() >= 8) {
+    region |= getBodyRoiRect();
+  }
+  region &= cv::Rect(0, 0, frame.cols, frame.rows);
 
+  cv::Mat target = frame(region);
+  cv::LUT(target, adjustmentLut, target);
+  // Template matching reads the luma plane directly in YUYV mode
+  if (captureMode == CaptureMode::YUYV && !roiLuma.empty()) {
+    cv::LUT(roiLuma, adjustmentLut, roiLuma);
+  }
+}
+
+bool VideoProcessor::handleCalibrationControl(const int &key, cv::Mat &frame) {
   switch (key) {
   case 13: // Enter key
     saveImage("calibration", frame, "assets/calibration/");
@@ -488,7 +1033,6 @@ bool VideoProcessor::handleCalibrationControl(const int &key, cv::Mat &frame) {
     } else {
       currentContrast += ADJUSTMENT_STEP;
     }
-    frameModified = true;
     break;
 
   case 1: // Down arrow on MacOS
@@ -497,14 +1041,9 @@ bool VideoProcessor::handleCalibrationControl(const int &key, cv::Mat &frame) {
     } else {
       currentContrast = std::max(0.0, currentContrast - ADJUSTMENT_STEP);
     }
-    frameModified = true;
     break;
   }
 
-  if (frameModified) {
-    adjustFrame(frame);
-  }
-
   return false;
 }
 
@@ -517,28 +1056,28 @@ void VideoProcessor::printVerboseCalibration(cv::Mat &frame) {
   const cv::Point textPos(20, 30);       // Starting position
   const int lineSpacing = 30;
 
-  // Create the status text
-  std::string modeText =
-      "Mode: " + std::string(currentMode == AdjustmentMode::Brightness
-                                 ? "Brightness"
-                                 : "Contrast");
-  std::string brightnessText =
-      "Brightness: " +
-      std::to_string(std::round(currentBrightness * 100) / 100);
-  std::string contrastText =
-      "Contrast: " + std::to_string(std::round(currentContrast * 100) / 100);
-
   // Add background rectangle for better readability
   cv::Rect backgroundRect(10, 5, 250, 90);
   cv::rectangle(frame, backgroundRect, cv::Scalar(0, 0, 0), -1);
 
-  // Draw the text
-  cv::putText(frame, modeText, textPos, fontFace, fontScale, textColor,
+  // Draw the status text, formatted in the reused overlayText buffer
+  char line[64];
+  std::snprintf(line, sizeof(line), "Mode: %s",
+                currentMode == AdjustmentMode::Brightness ? "Brightness"
+                                                          : "Contrast");
+  overlayText.assign(line);
+  cv::putText(frame, overlayText, textPos, fontFace, fontScale, textColor,
               thickness);
-  cv::putText(frame, brightnessText,
+  std::snprintf(line, sizeof(line), "Brightness: %f",
+                std::round(currentBrightness * 100) / 100);
+  overlayText.assign(line);
+  cv::putText(frame, overlayText,
               cv::Point(textPos.x, textPos.y + lineSpacing), fontFace,
               fontScale, textColor, thickness);
-  cv::putText(frame, contrastText,
+  std::snprintf(line, sizeof(line), "Contrast: %f",
+                std::round(currentContrast * 100) / 100);
+  overlayText.assign(line);
+  cv::putText(frame, overlayText,
               cv::Point(textPos.x, textPos.y + 2 * lineSpacing), fontFace,
               fontScale, textColor, thickness);
 }
@@ -0,0 +1,222 @@
+#include "../include/recorder.hpp"
+#include "../include/logger.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t alignUp(uint64_t value) {
+  return (value + RECORDING_ALIGNMENT - 1) / RECORDING_ALIGNMENT *
+         RECORDING_ALIGNMENT;
+}
+
+/**
+ * RECORDER
+ */
+
+FrameRecorder::~FrameRecorder() { close(); }
+
+bool FrameRecorder::open(const std::string &path, cv::Size size, int type,
+                         double brightness, double contrast) {
+  close();
+
+  file.open(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    std::cerr << "Error: could not create recording " << path << std::endl;
+    return false;
+  }
+
+  header = RecordingHeader{};
+  std::memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+  header.version = RECORDING_VERSION;
+  header.width = size.width;
+  header.height = size.height;
+  header.type = type;
+  header.frameBytes = static_cast<uint64_t>(size.area()) *
+                      CV_ELEM_SIZE(type);
+  header.brightness = brightness;
+  header.contrast = contrast;
+  index.clear();
+
+  // Placeholder, rewritten on close
+  std::vector<char> padded(alignUp(sizeof(header)), 0);
+  std::memcpy(padded.data(), &header, sizeof(header));
+  file.write(padded.data(), padded.size());
+  offset = padded.size();
+
+  return file.good();
+}
+
+bool FrameRecorder::append(const cv::Mat &frame, int64_t timestampNs) {
+  if (!isOpen()) {
+    return false;
+  }
+  if (frame.cols != header.width || frame.rows != header.height ||
+      frame.type() != header.type) {
+    std::cerr << "Error: frame does not match the recording format"
+              << std::endl;
+    return false;
+  }
+
+  // Roi crops are not continuous, write them row by row
+  const size_t rowBytes = frame.cols * frame.elemSize();
+  for (int y = 0; y < frame.rows; ++y) {
+    file.write(reinterpret_cast<const char *>(frame.ptr(y)), rowBytes);
+  }
+  static const char zeros[RECORDING_ALIGNMENT] = {};
+  uint64_t padding = alignUp(header.frameBytes) - header.frameBytes;
+  file.write(zeros, padding);
+  if (!file.good()) {
+    std::cerr << "Error: could not write to the recording" << std::endl;
+    return false;
+  }
+
+  index.push_back({offset, timestampNs});
+  offset += header.frameBytes + padding;
+  return true;
+}
+
+void FrameRecorder::close() {
+  if (!isOpen()) {
+    return;
+  }
+
+  header.frameCount = index.size();
+  header.indexOffset = offset;
+  file.write(reinterpret_cast<const char *>(index.data()),
+             index.size() * sizeof(RecordingIndexEntry));
+  file.seekp(0);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.close();
+
+  LOG_INFO("(verbose) Recorded %zu frames", index.size());
+  index.clear();
+}
+
+bool FrameRecorder::isOpen() const { return file.is_open(); }
+
+/**
+ * REPLAY
+ */
+
+FrameReplay::~FrameReplay() { close(); }
+
+bool FrameReplay::open(const std::string &path) {
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "Error: could not open recording " << path << std::endl;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(RecordingHeader)) {
+    std::cerr << "Error: " << path << " is not a recording" << std::endl;
+    ::close(fd);
+    return false;
+  }
+
+  // Read-only: the processor adjusts frames into its own buffer, a stray
+  // write would otherwise copy the page
+  size = st.st_size;
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    std::cerr << "Error: could not map recording " << path << std::endl;
+    size = 0;
+    return false;
+  }
+  data = static_cast<uint8_t *>(mapping);
+  madvise(data, size, MADV_SEQUENTIAL);
+
+  std::memcpy(&header, data, sizeof(header));
+  const uint64_t dataStart = alignUp(sizeof(header));
+  if (std::memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version < 1 || header.version > RECORDING_VERSION ||
+      header.width <= 0 || header.height <= 0 || header.frameBytes == 0 ||
+      header.frameBytes > size ||
+      header.frameBytes != static_cast<uint64_t>(header.width) *
+                               header.height * CV_ELEM_SIZE(header.type)) {
+    std::cerr << "Error: " << path << " is not a recording" << std::endl;
+    close();
+    return false;
+  }
+
+  // Written so that a corrupt header cannot overflow
+  if (header.indexOffset != 0 && header.indexOffset <= size &&
+      header.frameCount <=
+          (size - header.indexOffset) / sizeof(RecordingIndexEntry)) {
+    index =
+        reinterpret_cast<const RecordingIndexEntry *>(data + header.indexOffset);
+    count = header.frameCount;
+  } else {
+    // Never closed: every complete frame is still usable
+    std::cerr << "Warning: " << path << " has no index, timestamps are lost"
+              << std::endl;
+    count = size < dataStart ? 0 : (size - dataStart) / alignUp(header.frameBytes);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (frameOffset(i) > size || header.frameBytes > size - frameOffset(i)) {
+      std::cerr << "Error: " << path << " is truncated" << std::endl;
+      close();
+      return false;
+    }
+  }
+
+  next = 0;
+  return true;
+}
+
+void FrameReplay::close() {
+  if (data) {
+    munmap(data, size);
+  }
+  data = nullptr;
+  size = 0;
+  index = nullptr;
+  count = 0;
+  next = 0;
+}
+
+// No copy: the Mat header points into the mapping
+bool FrameReplay::read(cv::Mat &frame) {
+  if (next >= count) {
+    return false;
+  }
+  frame = frameAt(next++);
+  return true;
+}
+
+cv::Rect FrameReplay::roi() const {
+  return cv::Rect(0, 0, header.width, header.height);
+}
+
+size_t FrameReplay::frameCount() const { return count; }
+
+cv::Mat FrameReplay::frameAt(size_t i) const {
+  return cv::Mat(header.height, header.width, header.type,
+                 data + frameOffset(i));
+}
+
+int64_t FrameReplay::timestampAt(size_t i) const {
+  return index ? index[i].timestampNs : 0;
+}
+
+bool FrameReplay::calibration(double &brightness, double &contrast) const {
+  if (header.version < 2) {
+    return false;
+  }
+  brightness = header.brightness;
+  contrast = header.contrast;
+  return true;
+}
+
+uint64_t FrameReplay::frameOffset(size_t i) const {
+  if (index) {
+    return index[i].offset;
+  }
+  return alignUp(sizeof(RecordingHeader)) + i * alignUp(header.frameBytes);
+}
@@ -0,0 +1,55 @@
+#include "../include/streams.hpp"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+void processVideoStreams(Streams &streams) {
+  std::atomic<bool> stopping{false};
+  // Cleared by the thread of a stream once it ends
+  std::vector<std::atomic<bool>> running(streams.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < streams.size(); ++i) {
+    running[i] = streams[i]->open();
+    if (!running[i]) {
+      continue;
+    }
+    threads.emplace_back([&streams, &running, &stopping, i] {
+      VideoProcessor &stream = *streams[i];
+      while (!stopping.load(std::memory_order_relaxed) && stream.step()) {
+        stream.publish();
+      }
+      running[i] = false;
+    });
+  }
+
+  auto isRunning = [&running] {
+    return std::any_of(running.begin(), running.end(),
+                       [](const std::atomic<bool> &r) { return r.load(); });
+  };
+  while (isRunning()) {
+    for (auto &stream : streams) {
+      stream->showPublished();
+    }
+    int key = cv::waitKey(10);
+    if (key == 27) {
+      break;
+    }
+  }
+
+  // A stream blocked in a read stops once the read returns
+  stopping = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (auto &stream : streams) {
+    stream->close();
+  }
+  cv::destroyAllWindows();
+}
+
+std::string streamPath(const std::string &path, const std::string &name) {
+  std::filesystem::path p(path);
+  std::string file = p.stem().string() + "_" + name + p.extension().string();
+  return (p.parent_path() / file).string();
+}
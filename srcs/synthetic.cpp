@@ -0,0 +1,276 @@
+#include "../include/synthetic.hpp"
+#include "../include/alloc_counter.hpp"
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+// Well apart from each other, from the separator, and from the yellow of the
+// body box outline
+const cv::Vec3b headerPalette[] = {
+    cv::Vec3b(40, 40, 220),  cv::Vec3b(40, 200, 40),  cv::Vec3b(220, 60, 40),
+    cv::Vec3b(200, 40, 200), cv::Vec3b(200, 200, 40), cv::Vec3b(40, 140, 255),
+    cv::Vec3b(245, 245, 245), cv::Vec3b(30, 30, 30)};
+const cv::Vec3b separatorColor(128, 128, 128);
+const cv::Scalar background(170, 170, 170);
+
+// Same geometry as VideoProcessor::detectTemplate()
+const int offTop = 25;
+const int offBottom = 55;
+const int headerTop = 40;
+const int bodyOffset = 16;
+// Plain color around the body box, so that small shifts stay inside
+const int bodyMargin = 16;
+
+size_t editDistance(const std::string &a, const std::string &b) {
+  std::vector<size_t> row(b.size() + 1);
+  for (size_t j = 0; j <= b.size(); ++j) {
+    row[j] = j;
+  }
+  for (size_t i = 1; i <= a.size(); ++i) {
+    size_t diagonal = row[0];
+    row[0] = i;
+    for (size_t j = 1; j <= b.size(); ++j) {
+      size_t above = row[j];
+      row[j] = std::min({row[j] + 1, row[j - 1] + 1,
+                         diagonal + (a[i - 1] == b[j - 1] ? 0 : 1)});
+      diagonal = above;
+    }
+  }
+  return row[b.size()];
+}
+
+} // namespace
+
+const std::string SyntheticSource::instructions = "+-<>[].,";
+
+/**
+ * CONSTRUCTOR
+ */
+
+SyntheticSource::SyntheticSource(const std::string &program,
+                                 const SyntheticOptions &options)
+    : program(program), options(options), rng(options.seed),
+      palette(std::begin(headerPalette), std::end(headerPalette)),
+      separator(separatorColor) {}
+
+/**
+ * SCENE
+ */
+
+bool SyntheticSource::load() {
+  cv::Mat start = cv::imread("templates/header/border/header_start.png",
+                             cv::IMREAD_GRAYSCALE);
+  cv::Mat end = cv::imread("templates/header/border/header_end.png",
+                           cv::IMREAD_GRAYSCALE);
+  if (start.empty() || end.empty()) {
+    std::cerr << "Error: Could not load the header border templates"
+              << std::endl;
+    return false;
+  }
+
+  const cv::Rect frame = roi();
+  const int center = frame.width / 2;
+  const int sectionsHeight = SYNTHETIC_SECTION_HEIGHT * instructions.size();
+  const int endTop =
+      headerTop + sectionsHeight + end.rows + offTop + offBottom;
+  if (start.cols > frame.width || end.cols > frame.width ||
+      endTop + end.rows > frame.height) {
+    std::cerr << "Error: the header does not fit in the roi" << std::endl;
+    return false;
+  }
+
+  headerScene.create(frame.size(), CV_8UC3);
+  headerScene = background;
+
+  cv::Mat border;
+  cv::cvtColor(start, border, cv::COLOR_GRAY2BGR);
+  border.copyTo(headerScene(
+      cv::Rect(center - start.cols / 2, headerTop, start.cols, start.rows)));
+  cv::cvtColor(end, border, cv::COLOR_GRAY2BGR);
+  border.copyTo(
+      headerScene(cv::Rect(center - end.cols / 2, endTop, end.cols, end.rows)));
+
+  // Wider than the header roi, so that the analysed sections are plain
+  const int sectionsTop = headerTop + start.rows + offTop;
+  for (size_t i = 0; i < instructions.size(); ++i) {
+    cv::Rect section(center - 80, sectionsTop + SYNTHETIC_SECTION_HEIGHT * i,
+                     160, SYNTHETIC_SECTION_HEIGHT);
+    headerScene(section) = cv::Scalar(palette[i][0], palette[i][1],
+                                      palette[i][2]);
+  }
+
+  // The body box lies right under the end border. While the header is in
+  // view it shows the separator, which is the first color the body expects.
+  bodyRect = cv::Rect(center - bodyMargin, endTop + bodyOffset - bodyMargin,
+                      BODY_ROI_WIDTH + 2 * bodyMargin,
+                      BODY_ROI_HEIGHT + 2 * bodyMargin);
+  headerScene(bodyRect) =
+      cv::Scalar(separator[0], separator[1], separator[2]);
+
+  scene.create(frame.size(), CV_8UC3);
+  next = 0;
+  return true;
+}
+
+// Header frames, then one stripe per instruction, each followed by a
+// separator stripe.
+void SyntheticSource::renderScene(size_t i) {
+  if (i < static_cast<size_t>(options.headerFrames)) {
+    headerScene.copyTo(scene);
+    return;
+  }
+
+  size_t stripe = (i - options.headerFrames) / options.stripeFrames;
+  cv::Vec3b color = separator;
+  if (stripe % 2 == 0 && stripe / 2 < program.size()) {
+    color = palette[instructions.find(program[stripe / 2])];
+  }
+
+  scene = background;
+  scene(bodyRect) = cv::Scalar(color[0], color[1], color[2]);
+}
+
+// Slow zoom and lighting drifts, plus per pixel noise
+void SyntheticSource::applyEffects(cv::Mat &frame, size_t i) {
+  const double pi = 3.14159265358979323846;
+
+  if (options.scale != 0.0) {
+    // Zoom around the center, kept in a Matx to stay off the heap
+    double zoom = 1.0 + options.scale * std::sin(2 * pi * i / 97.0);
+    cv::Matx23d transform(zoom, 0, (1 - zoom) * scene.cols / 2.0, 0, zoom,
+                          (1 - zoom) * scene.rows / 2.0);
+    cv::warpAffine(scene, frame, transform, scene.size(), cv::INTER_LINEAR,
+                   cv::BORDER_REPLICATE);
+  } else {
+    scene.copyTo(frame);
+  }
+
+  if (options.lighting != 0.0) {
+    double shift = options.lighting * std::sin(2 * pi * i / 61.0);
+    frame.convertTo(frame, -1, 1.0, shift);
+  }
+
+  if (options.noise > 0.0) {
+    noise.create(frame.size(), CV_8UC3);
+    rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(128),
+             cv::Scalar::all(options.noise));
+    cv::addWeighted(frame, 1.0, noise, 1.0, -128.0, frame);
+  }
+}
+
+/**
+ * SOURCE
+ */
+
+bool SyntheticSource::read(cv::Mat &frame) {
+  if (headerScene.empty() || next >= frameCount()) {
+    return false;
+  }
+
+  renderScene(next);
+  applyEffects(frame, next);
+  ++next;
+  return true;
+}
+
+cv::Rect SyntheticSource::roi() const {
+  return cv::Rect(0, 0, ROI_WIDTH, ROI_HEIGHT);
+}
+
+size_t SyntheticSource::frameCount() const {
+  // A trailing separator stripe closes the last instruction
+  return options.headerFrames +
+         (2 * program.size() + 1) * options.stripeFrames;
+}
+
+/**
+ * BENCHMARK
+ */
+
+bool runSyntheticBenchmark(VideoProcessor &processor,
+                           const std::string &programPath,
+                           const SyntheticOptions &options) {
+  std::ifstream file(programPath);
+  if (!file.is_open()) {
+    std::cerr << "Error: could not open " << programPath << std::endl;
+    return false;
+  }
+  std::string expected;
+  char c;
+  while (file.get(c)) {
+    if (SyntheticSource::instructions.find(c) != std::string::npos) {
+      expected.push_back(c);
+    }
+  }
+  if (expected.empty()) {
+    std::cerr << "Error: no instruction in " << programPath << std::endl;
+    return false;
+  }
+
+  auto source = std::make_unique<SyntheticSource>(expected, options);
+  if (!source->load()) {
+    return false;
+  }
+  processor.setFrameSource(std::move(source));
+  processor.saveImages = false;
+  processor.verifyMatching = true;
+  if (!processor.open()) {
+    return false;
+  }
+
+  size_t frames = 0;
+#ifdef TRICOT_COUNT_ALLOCATIONS
+  size_t bodyFrames = 0;
+  size_t steadyFrames = 0;
+  size_t steadyAllocations = 0;
+#endif
+  auto start = std::chrono::steady_clock::now();
+  while (true) {
+#ifdef TRICOT_COUNT_ALLOCATIONS
+    size_t allocationsBefore = allocationCount();
+#endif
+    if (!processor.step()) {
+      break;
+    }
+    ++frames;
+#ifdef TRICOT_COUNT_ALLOCATIONS
+    // Body frames after the warm up are the steady state
+    if (processor.isDecodingBody() &&
+        ++bodyFrames > SYNTHETIC_WARMUP_FRAMES) {
+      ++steadyFrames;
+      steadyAllocations += allocationCount() - allocationsBefore;
+    }
+#endif
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  processor.close();
+
+  const std::string &decoded = processor.getCommand();
+  size_t distance = editDistance(expected, decoded);
+  double accuracy =
+      1.0 - static_cast<double>(distance) /
+                std::max(expected.size(), decoded.size());
+
+  std::cout << "Expected: " << expected << "\nDecoded:  " << decoded
+            << "\nAccuracy: " << accuracy * 100 << " % (" << distance
+            << " edits)\nFrames:   " << frames << " in " << seconds << " s, "
+            << (seconds > 0 ? frames / seconds : 0) << " fps" << std::endl;
+  std::cout << "Tiled matching: " << processor.getMatchingMismatches()
+            << " mismatches against a full match" << std::endl;
+#ifdef TRICOT_COUNT_ALLOCATIONS
+  std::cout << "Allocations: " << steadyAllocations << " over "
+            << steadyFrames << " steady state frames" << std::endl;
+  // The steady state must not touch the heap
+  if (steadyAllocations != 0) {
+    std::cerr << "Error: steady state body frames allocated" << std::endl;
+    return false;
+  }
+#endif
+
+  return distance == 0 && processor.getMatchingMismatches() == 0;
+}